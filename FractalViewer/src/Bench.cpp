@@ -0,0 +1,132 @@
+#include "Bench.h"
+#include "Renderer.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+struct BenchView {
+	const char* name;
+	const char* re;
+	const char* im;
+	// Magnification 10^zoom, as View::parse() takes it
+	double zoom;
+	int max_iters;
+};
+
+constexpr unsigned int bench_width = 1280, bench_height = 720;
+
+const BenchView bench_views[] = {
+	{ "full", "-0.5", "0", 0.0, 1000 },
+	{ "seahorse", "-0.7436438870371587", "0.1318259042053119", 3.0, 5000 },
+	// The period 3 minibrot on the real axis, its cardioid covering most of the view
+	{ "minibrot", "-1.7548776662466927600495", "0", 2.1, 20000 },
+	// c = i is a Misiurewicz point, so its surroundings look alike at any depth and the coordinates stay exact
+	{ "deep-1e50", "0", "1", 50.0, 5000 },
+	// A period 95 minibrot at the tip of the period 3 bulb's antenna; with this budget its interior
+	// dominates the time unless the perturbation kernel settles interior pixels early
+	{ "deep-minibrot", "-0.101096363845294927955634900413589339565258", "0.956286510809698630152005513221601006819917", 24.0, 100000 },
+	{ "deep-1e300", "0", "1", 300.0, 5000 },
+};
+
+View makeView(const BenchView& bench) {
+	View view;
+	view.width = bench_width;
+	view.height = bench_height;
+	view.max_iters = bench.max_iters;
+	View::parse(bench.re, bench.im, bench.zoom, view);
+	return view;
+}
+
+struct Result {
+	double seconds;
+	uint64_t iterations;
+};
+
+// Fastest of repeat renders, each with a new renderer so nothing of the last one is reused
+Result measure(TileScheduler& scheduler, const View& view, int repeat) {
+	Result best = { 0.0, 0 };
+	for (int i = 0; i < repeat; i++) {
+		Renderer renderer(scheduler);
+		Frame frame;
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		renderer.render(view, frame);
+		double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		if (i == 0 || seconds < best.seconds) {
+			best = { seconds, renderer.totals().iterations };
+		}
+	}
+	return best;
+}
+
+}
+
+int runBench(int argc, char** argv) {
+	unsigned int max_threads = std::max(1u, std::thread::hardware_concurrency());
+	int repeat = 3;
+	std::string only;
+	for (int i = 0; i < argc; i++) {
+		std::string arg = argv[i];
+		if (arg == "--threads" && i + 1 < argc) {
+			max_threads = std::max(1, atoi(argv[++i]));
+		} else if (arg == "--repeat" && i + 1 < argc) {
+			repeat = std::max(1, atoi(argv[++i]));
+		} else if (arg == "--view" && i + 1 < argc) {
+			only = argv[++i];
+		} else {
+			std::cout << "Usage: FractalViewer bench [--threads N] [--repeat R] [--view NAME]" << std::endl;
+			return 1;
+		}
+	}
+
+	std::vector<const BenchView*> selected;
+	for (const BenchView& bench : bench_views) {
+		if (only.empty() || only == bench.name) {
+			selected.push_back(&bench);
+		}
+	}
+	if (selected.empty()) {
+		std::cout << "Unknown view " << only << std::endl;
+		return 1;
+	}
+
+	// Powers of two up to the thread limit, and the limit itself
+	std::vector<unsigned int> thread_counts;
+	for (unsigned int threads = 1; threads < max_threads; threads *= 2) {
+		thread_counts.push_back(threads);
+	}
+	thread_counts.push_back(max_threads);
+
+	// Iterations are the ones the kernels actually ran (Renderer::Totals): work saved by periodicity
+	// checks, tiling or the perturbation series doesn't count, so seconds tells whether a build got
+	// faster and Miter/s how fast the iteration loops themselves run
+	std::cout << std::left << std::setw(16) << "view" << std::right << std::setw(8) << "threads" << std::setw(12) << "seconds"
+		<< std::setw(14) << "Miter" << std::setw(12) << "Miter/s" << std::setw(14) << "Miter/s/core" << std::setw(10) << "scaling"
+		<< std::endl;
+	for (const BenchView* bench : selected) {
+		View view = makeView(*bench);
+		double single = 0.0;
+		for (unsigned int threads : thread_counts) {
+			TileScheduler scheduler(threads);
+			Result result = measure(scheduler, view, repeat);
+			if (threads == 1) {
+				single = result.seconds;
+			}
+			double rate = result.iterations / result.seconds * 1e-6;
+			std::cout << std::left << std::setw(16) << bench->name << std::right << std::setw(8) << threads
+				<< std::fixed << std::setprecision(4) << std::setw(12) << result.seconds
+				<< std::setprecision(1) << std::setw(14) << result.iterations * 1e-6 << std::setw(12) << rate
+				<< std::setw(14) << rate / threads << std::setprecision(2) << std::setw(10) << single / result.seconds
+				<< std::endl;
+		}
+	}
+	return 0;
+}
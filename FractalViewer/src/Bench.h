@@ -0,0 +1,6 @@
+#pragma once
+
+// `FractalViewer bench [--threads N] [--repeat R] [--view NAME]` renders a fixed set of views without a
+// window and prints wall time, the iterations the kernels ran and Miter/s for every thread count
+// from 1 up to N.
+int runBench(int argc, char** argv);
@@ -0,0 +1,462 @@
+#include "BigFixed.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+
+BigFixed::BigFixed() : limbs(3, 0) {}
+
+BigFixed::BigFixed(double value, unsigned int fracLimbs) : limbs(fracLimbs + 1, 0) {
+	negative = value < 0;
+	double a = fabs(value);
+	double integer = floor(a);
+	limbs[fracLimbs] = (uint32_t)integer;
+	a -= integer;
+	for (unsigned int i = fracLimbs; i-- > 0 && a > 0;) {
+		a *= 4294967296.0;
+		double limb = floor(a);
+		limbs[i] = (uint32_t)limb;
+		a -= limb;
+	}
+	normalizeZero();
+}
+
+BigFixed BigFixed::fromScaled(double value, long long exponent, unsigned int fracLimbs) {
+	BigFixed result;
+	result.limbs.assign(fracLimbs + 1, 0);
+	if (value == 0.0 || !std::isfinite(value)) {
+		return result;
+	}
+
+	result.negative = value < 0;
+	int e;
+	double m = frexp(fabs(value), &e);
+	uint64_t mantissa = (uint64_t)ldexp(m, 53);
+	long long lsb = (long long)e + exponent - 53 + 32ll * fracLimbs;
+	long long bits = 32ll * (fracLimbs + 1);
+	for (int i = 0; i < 53; i++) {
+		long long pos = lsb + i;
+		if (((mantissa >> i) & 1) && pos >= 0 && pos < bits) {
+			result.limbs[pos / 32] |= 1u << (pos % 32);
+		}
+	}
+	result.normalizeZero();
+	return result;
+}
+
+bool BigFixed::parse(const std::string& text, unsigned int fracLimbs, BigFixed& out) {
+	size_t pos = 0;
+	bool negative = false;
+	if (pos < text.size() && (text[pos] == '-' || text[pos] == '+')) {
+		negative = text[pos] == '-';
+		pos++;
+	}
+
+	uint64_t integer = 0;
+	size_t digits = 0;
+	while (pos < text.size() && isdigit((unsigned char)text[pos])) {
+		integer = integer * 10 + (text[pos++] - '0');
+		if (integer > 0xffffffffull) {
+			return false;
+		}
+		digits++;
+	}
+
+	std::string fraction;
+	if (pos < text.size() && text[pos] == '.') {
+		pos++;
+		while (pos < text.size() && isdigit((unsigned char)text[pos])) {
+			fraction.push_back(text[pos++]);
+		}
+	}
+	if (pos != text.size() || digits + fraction.size() == 0) {
+		return false;
+	}
+
+	// One guard limb absorbs the truncation of the repeated division by ten
+	std::vector<uint32_t> limbs(fracLimbs + 2, 0);
+	for (size_t i = fraction.size(); i-- > 0;) {
+		limbs.back() = fraction[i] - '0';
+		uint64_t rem = 0;
+		for (size_t j = limbs.size(); j-- > 0;) {
+			uint64_t cur = (rem << 32) | limbs[j];
+			limbs[j] = (uint32_t)(cur / 10);
+			rem = cur % 10;
+		}
+	}
+	limbs.erase(limbs.begin());
+	limbs.back() = (uint32_t)integer;
+
+	out.negative = negative;
+	out.limbs = std::move(limbs);
+	out.normalizeZero();
+	return true;
+}
+
+BigFixed BigFixed::withPrecision(unsigned int fracLimbs) const {
+	BigFixed result;
+	result.negative = negative;
+	result.limbs.assign(fracLimbs + 1, 0);
+	unsigned int own = this->fracLimbs();
+	for (unsigned int i = 0; i <= fracLimbs; i++) {
+		int source = (int)i - (int)fracLimbs + (int)own;
+		if (source >= 0) {
+			result.limbs[i] = limbs[source];
+		}
+	}
+	result.normalizeZero();
+	return result;
+}
+
+bool BigFixed::isZero() const {
+	return std::all_of(limbs.begin(), limbs.end(), [](uint32_t limb) { return limb == 0; });
+}
+
+double BigFixed::toDouble() const {
+	return scaledToDouble(0);
+}
+
+double BigFixed::scaledToDouble(long long exponent) const {
+	double result = 0.0;
+	int frac = (int)fracLimbs();
+	int used = 0;
+	for (int i = (int)limbs.size() - 1; i >= 0 && used < 3; i--) {
+		if (limbs[i] != 0 || used > 0) {
+			long long e = 32ll * (i - frac) + exponent;
+			result += ldexp((double)limbs[i], (int)std::min(std::max(e, -2000ll), 2000ll));
+			used++;
+		}
+	}
+	return negative ? -result : result;
+}
+
+std::string BigFixed::toString(unsigned int digits) const {
+	std::string text = negative ? "-" : "";
+	text += std::to_string(limbs.back());
+	if (digits == 0) {
+		return text;
+	}
+
+	text.push_back('.');
+	std::vector<uint32_t> fraction(limbs.begin(), limbs.end() - 1);
+	for (unsigned int d = 0; d < digits; d++) {
+		uint64_t carry = 0;
+		for (uint32_t& limb : fraction) {
+			uint64_t cur = (uint64_t)limb * 10 + carry;
+			limb = (uint32_t)cur;
+			carry = cur >> 32;
+		}
+		text.push_back((char)('0' + carry));
+	}
+	return text;
+}
+
+BigFixed BigFixed::operator-() const {
+	BigFixed result = *this;
+	result.negative = !negative;
+	result.normalizeZero();
+	return result;
+}
+
+int BigFixed::compareMagnitude(const std::vector<uint32_t>& a, const std::vector<uint32_t>& b) {
+	for (size_t i = a.size(); i-- > 0;) {
+		if (a[i] != b[i]) {
+			return a[i] < b[i] ? -1 : 1;
+		}
+	}
+	return 0;
+}
+
+BigFixed BigFixed::addSigned(const BigFixed& a, const BigFixed& b, bool negateB) {
+	unsigned int frac = std::max(a.fracLimbs(), b.fracLimbs());
+	BigFixed x = a.fracLimbs() == frac ? a : a.withPrecision(frac);
+	BigFixed y = b.fracLimbs() == frac ? b : b.withPrecision(frac);
+	bool yNegative = y.negative != negateB;
+
+	if (x.negative == yNegative) {
+		uint64_t carry = 0;
+		for (size_t i = 0; i < x.limbs.size(); i++) {
+			uint64_t sum = (uint64_t)x.limbs[i] + y.limbs[i] + carry;
+			x.limbs[i] = (uint32_t)sum;
+			carry = sum >> 32;
+		}
+		x.normalizeZero();
+		return x;
+	}
+
+	bool swap = compareMagnitude(x.limbs, y.limbs) < 0;
+	const std::vector<uint32_t>& big = swap ? y.limbs : x.limbs;
+	const std::vector<uint32_t>& small = swap ? x.limbs : y.limbs;
+	BigFixed result;
+	result.negative = swap ? yNegative : x.negative;
+	result.limbs.resize(big.size());
+	int64_t borrow = 0;
+	for (size_t i = 0; i < big.size(); i++) {
+		int64_t diff = (int64_t)big[i] - small[i] - borrow;
+		borrow = diff < 0;
+		result.limbs[i] = (uint32_t)(diff + (borrow << 32));
+	}
+	result.normalizeZero();
+	return result;
+}
+
+BigFixed operator+(const BigFixed& a, const BigFixed& b) {
+	return BigFixed::addSigned(a, b, false);
+}
+
+BigFixed operator-(const BigFixed& a, const BigFixed& b) {
+	return BigFixed::addSigned(a, b, true);
+}
+
+BigFixed operator*(const BigFixed& a, const BigFixed& b) {
+	BigFixed result;
+	BigFixed::Workspace work;
+	if (&a == &b) {
+		BigFixed::square(a, result, work);
+	} else {
+		BigFixed::multiply(a, b, result, work);
+	}
+	return result;
+}
+
+void BigFixed::add(const BigFixed& a, const BigFixed& b, BigFixed& out) {
+	addSignedInPlace(a, b, false, out);
+}
+
+void BigFixed::subtract(const BigFixed& a, const BigFixed& b, BigFixed& out) {
+	addSignedInPlace(a, b, true, out);
+}
+
+void BigFixed::addSignedInPlace(const BigFixed& a, const BigFixed& b, bool negateB, BigFixed& out) {
+	if (a.limbs.size() != b.limbs.size()) {
+		out = addSigned(a, b, negateB);
+		return;
+	}
+
+	// Every limb is read before the same limb of out is written, so out may be a or b
+	size_t n = a.limbs.size();
+	bool aNegative = a.negative, bNegative = b.negative != negateB;
+	if (aNegative == bNegative) {
+		out.limbs.resize(n);
+		uint64_t carry = 0;
+		for (size_t i = 0; i < n; i++) {
+			uint64_t sum = (uint64_t)a.limbs[i] + b.limbs[i] + carry;
+			out.limbs[i] = (uint32_t)sum;
+			carry = sum >> 32;
+		}
+		out.negative = aNegative;
+		out.normalizeZero();
+		return;
+	}
+
+	bool swap = compareMagnitude(a.limbs, b.limbs) < 0;
+	const std::vector<uint32_t>& big = swap ? b.limbs : a.limbs;
+	const std::vector<uint32_t>& small = swap ? a.limbs : b.limbs;
+	out.limbs.resize(n);
+	int64_t borrow = 0;
+	for (size_t i = 0; i < n; i++) {
+		int64_t diff = (int64_t)big[i] - small[i] - borrow;
+		borrow = diff < 0;
+		out.limbs[i] = (uint32_t)(diff + (borrow << 32));
+	}
+	out.negative = swap ? bNegative : aNegative;
+	out.normalizeZero();
+}
+
+static void schoolbookMultiply(const uint32_t* a, size_t n, const uint32_t* b, size_t m, uint32_t* out) {
+	std::fill(out, out + n + m, 0u);
+	for (size_t i = 0; i < n; i++) {
+		uint64_t carry = 0;
+		for (size_t j = 0; j < m; j++) {
+			uint64_t cur = (uint64_t)a[i] * b[j] + out[i + j] + carry;
+			out[i + j] = (uint32_t)cur;
+			carry = cur >> 32;
+		}
+		out[i + m] = (uint32_t)carry;
+	}
+}
+
+static void schoolbookSquare(const uint32_t* a, size_t n, uint32_t* out) {
+	std::fill(out, out + 2 * n, 0u);
+	// Each cross product a[i] a[j] appears twice in the square; add it once and double the sum
+	for (size_t i = 0; i < n; i++) {
+		uint64_t carry = 0;
+		for (size_t j = i + 1; j < n; j++) {
+			uint64_t cur = (uint64_t)a[i] * a[j] + out[i + j] + carry;
+			out[i + j] = (uint32_t)cur;
+			carry = cur >> 32;
+		}
+		out[i + n] = (uint32_t)carry;
+	}
+
+	uint32_t top = 0;
+	for (size_t k = 0; k < 2 * n; k++) {
+		uint32_t limb = out[k];
+		out[k] = (limb << 1) | top;
+		top = limb >> 31;
+	}
+
+	uint64_t carry = 0;
+	for (size_t i = 0; i < n; i++) {
+		uint64_t cur = (uint64_t)a[i] * a[i] + out[2 * i] + carry;
+		out[2 * i] = (uint32_t)cur;
+		cur = (cur >> 32) + out[2 * i + 1];
+		out[2 * i + 1] = (uint32_t)cur;
+		carry = cur >> 32;
+	}
+}
+
+// out[0, len) += x[0, n) with n <= len; the caller guarantees the sum fits
+static void addInto(uint32_t* out, size_t len, const uint32_t* x, size_t n) {
+	uint64_t carry = 0;
+	size_t i = 0;
+	for (; i < n; i++) {
+		uint64_t sum = (uint64_t)out[i] + x[i] + carry;
+		out[i] = (uint32_t)sum;
+		carry = sum >> 32;
+	}
+	for (; carry && i < len; i++) {
+		uint64_t sum = (uint64_t)out[i] + carry;
+		out[i] = (uint32_t)sum;
+		carry = sum >> 32;
+	}
+}
+
+// out[0, len) -= x[0, n) with n <= len; the caller guarantees the result isn't negative
+static void subtractFrom(uint32_t* out, size_t len, const uint32_t* x, size_t n) {
+	int64_t borrow = 0;
+	size_t i = 0;
+	for (; i < n; i++) {
+		int64_t diff = (int64_t)out[i] - x[i] - borrow;
+		borrow = diff < 0;
+		out[i] = (uint32_t)(diff + (borrow << 32));
+	}
+	for (; borrow && i < len; i++) {
+		int64_t diff = (int64_t)out[i] - borrow;
+		borrow = diff < 0;
+		out[i] = (uint32_t)(diff + (borrow << 32));
+	}
+}
+
+// out = |a - b| for a of h limbs and b of l <= h limbs; returns whether a < b
+static bool absDifference(const uint32_t* a, size_t h, const uint32_t* b, size_t l, uint32_t* out) {
+	bool less = false;
+	for (size_t i = h; i-- > 0;) {
+		uint32_t bi = i < l ? b[i] : 0;
+		if (a[i] != bi) {
+			less = a[i] < bi;
+			break;
+		}
+	}
+
+	int64_t borrow = 0;
+	for (size_t i = 0; i < h; i++) {
+		int64_t ai = a[i], bi = i < l ? b[i] : 0;
+		int64_t diff = (less ? bi - ai : ai - bi) - borrow;
+		borrow = diff < 0;
+		out[i] = (uint32_t)(diff + (borrow << 32));
+	}
+	return less;
+}
+
+// Scratch limbs needed by multiplyMagnitude and squareMagnitude for n-limb operands
+static size_t karatsubaScratch(size_t n) {
+	size_t total = 0;
+	while (n >= BigFixed::karatsuba_limbs) {
+		size_t h = (n + 1) / 2;
+		total += 6 * h + 1;
+		n = h;
+	}
+	return total;
+}
+
+// Full 2n-limb product. With the subtractive form, a0 b1 + a1 b0 = a0 b0 + a1 b1 - (a0 - a1)(b0 - b1),
+// the differences fit in h limbs and no carry limb is needed.
+static void multiplyMagnitude(const uint32_t* a, const uint32_t* b, size_t n, uint32_t* out, uint32_t* scratch) {
+	if (n < BigFixed::karatsuba_limbs) {
+		schoolbookMultiply(a, n, b, n, out);
+		return;
+	}
+
+	size_t h = (n + 1) / 2, l = n - h;
+	uint32_t* da = scratch;
+	uint32_t* db = da + h;
+	uint32_t* mid = db + h;
+	uint32_t* cross = mid + 2 * h;
+	uint32_t* rest = cross + 2 * h + 1;
+
+	bool aLess = absDifference(a, h, a + h, l, da);
+	bool bLess = absDifference(b, h, b + h, l, db);
+	multiplyMagnitude(a, b, h, out, rest);
+	multiplyMagnitude(a + h, b + h, l, out + 2 * h, rest);
+	multiplyMagnitude(da, db, h, mid, rest);
+
+	std::copy(out, out + 2 * h, cross);
+	cross[2 * h] = 0;
+	addInto(cross, 2 * h + 1, out + 2 * h, 2 * l);
+	if (aLess == bLess) {
+		subtractFrom(cross, 2 * h + 1, mid, 2 * h);
+	} else {
+		addInto(cross, 2 * h + 1, mid, 2 * h);
+	}
+	addInto(out + h, 2 * n - h, cross, 2 * h + 1);
+}
+
+// Full 2n-limb square; 2 a0 a1 = a0^2 + a1^2 - (a0 - a1)^2
+static void squareMagnitude(const uint32_t* a, size_t n, uint32_t* out, uint32_t* scratch) {
+	if (n < BigFixed::karatsuba_limbs) {
+		schoolbookSquare(a, n, out);
+		return;
+	}
+
+	size_t h = (n + 1) / 2, l = n - h;
+	uint32_t* da = scratch;
+	uint32_t* mid = da + h;
+	uint32_t* cross = mid + 2 * h;
+	uint32_t* rest = cross + 2 * h + 1;
+
+	absDifference(a, h, a + h, l, da);
+	squareMagnitude(a, h, out, rest);
+	squareMagnitude(a + h, l, out + 2 * h, rest);
+	squareMagnitude(da, h, mid, rest);
+
+	std::copy(out, out + 2 * h, cross);
+	cross[2 * h] = 0;
+	addInto(cross, 2 * h + 1, out + 2 * h, 2 * l);
+	subtractFrom(cross, 2 * h + 1, mid, 2 * h);
+	addInto(out + h, 2 * n - h, cross, 2 * h + 1);
+}
+
+void BigFixed::multiply(const BigFixed& a, const BigFixed& b, BigFixed& out, Workspace& work) {
+	size_t n = a.limbs.size(), m = b.limbs.size();
+	work.product.resize(n + m);
+	if (n == m && n >= karatsuba_limbs) {
+		work.scratch.resize(karatsubaScratch(n));
+		multiplyMagnitude(a.limbs.data(), b.limbs.data(), n, work.product.data(), work.scratch.data());
+	} else {
+		schoolbookMultiply(a.limbs.data(), n, b.limbs.data(), m, work.product.data());
+	}
+
+	// The product carries fa + fb fraction limbs; keep max(fa, fb) of them and one integer limb
+	out.assignProduct(work.product, std::min(a.fracLimbs(), b.fracLimbs()), std::max(a.fracLimbs(), b.fracLimbs()), a.negative != b.negative);
+}
+
+void BigFixed::square(const BigFixed& a, BigFixed& out, Workspace& work) {
+	size_t n = a.limbs.size();
+	work.product.resize(2 * n);
+	work.scratch.resize(karatsubaScratch(n));
+	squareMagnitude(a.limbs.data(), n, work.product.data(), work.scratch.data());
+	out.assignProduct(work.product, a.fracLimbs(), a.fracLimbs(), false);
+}
+
+void BigFixed::assignProduct(const std::vector<uint32_t>& product, size_t drop, unsigned int fracLimbs, bool negative) {
+	this->negative = negative;
+	limbs.assign(product.begin() + drop, product.begin() + drop + fracLimbs + 1);
+	normalizeZero();
+}
+
+void BigFixed::normalizeZero() {
+	if (negative && isZero()) {
+		negative = false;
+	}
+}
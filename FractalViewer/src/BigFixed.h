@@ -0,0 +1,66 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Signed fixed-point number with one 32-bit integer limb and a variable number of 32-bit fraction limbs.
+// Binary operations work at the larger precision of their operands and truncate.
+class BigFixed {
+public:
+	// Operands of at least this many limbs are multiplied with Karatsuba instead of schoolbook
+	static constexpr size_t karatsuba_limbs = 40;
+
+	// Buffers for the in-place operations; reusing one keeps a loop free of allocations after its first pass
+	struct Workspace {
+		std::vector<uint32_t> product, scratch;
+	};
+
+	BigFixed();
+	explicit BigFixed(double value, unsigned int fracLimbs = 2);
+
+	// value * 2^exponent, for magnitudes far outside the range of double
+	static BigFixed fromScaled(double value, long long exponent, unsigned int fracLimbs);
+	// Parses a plain decimal such as "-0.743643887037158704752191506114774"
+	static bool parse(const std::string& text, unsigned int fracLimbs, BigFixed& out);
+	static unsigned int limbsForBits(unsigned int bits) { return (bits + 31) / 32; }
+
+	unsigned int fracLimbs() const { return (unsigned int)limbs.size() - 1; }
+	BigFixed withPrecision(unsigned int fracLimbs) const;
+
+	bool isNegative() const { return negative; }
+	bool isZero() const;
+	double toDouble() const;
+	// value * 2^exponent, for values that would under- or overflow toDouble() on their own
+	double scaledToDouble(long long exponent) const;
+	std::string toString(unsigned int digits) const;
+
+	BigFixed operator-() const;
+	friend BigFixed operator+(const BigFixed& a, const BigFixed& b);
+	friend BigFixed operator-(const BigFixed& a, const BigFixed& b);
+	friend BigFixed operator*(const BigFixed& a, const BigFixed& b);
+	BigFixed& operator+=(const BigFixed& b) { return *this = *this + b; }
+	BigFixed& operator-=(const BigFixed& b) { return *this = *this - b; }
+
+	// In-place forms of the operators for hot loops. out may alias an operand and keeps its buffer
+	// when it already has the operands' precision.
+	static void add(const BigFixed& a, const BigFixed& b, BigFixed& out);
+	static void subtract(const BigFixed& a, const BigFixed& b, BigFixed& out);
+	static void multiply(const BigFixed& a, const BigFixed& b, BigFixed& out, Workspace& work);
+	static void square(const BigFixed& a, BigFixed& out, Workspace& work);
+
+private:
+	static int compareMagnitude(const std::vector<uint32_t>& a, const std::vector<uint32_t>& b);
+	static BigFixed addSigned(const BigFixed& a, const BigFixed& b, bool negateB);
+	static void addSignedInPlace(const BigFixed& a, const BigFixed& b, bool negateB, BigFixed& out);
+
+	// Takes the limbs of a full product that line up with a fixed point of fracLimbs fraction limbs
+	void assignProduct(const std::vector<uint32_t>& product, size_t drop, unsigned int fracLimbs, bool negative);
+
+	void normalizeZero();
+
+	bool negative = false;
+	// Little-endian magnitude; limbs.back() is the integer part
+	std::vector<uint32_t> limbs;
+};
@@ -0,0 +1,84 @@
+#include "BlaTable.h"
+
+#include <algorithm>
+#include <cmath>
+
+template <class T>
+static typename BlaTable<T>::Bla merge(const typename BlaTable<T>::Bla& x, const typename BlaTable<T>::Bla& y, const T& max_dc) {
+	using std::isfinite;
+	using std::sqrt;
+
+	typename BlaTable<T>::Bla z;
+	z.ar = y.ar * x.ar - y.ai * x.ai;
+	z.ai = y.ar * x.ai + y.ai * x.ar;
+	z.br = y.ar * x.br - y.ai * x.bi + y.br;
+	z.bi = y.ar * x.bi + y.ai * x.br + y.bi;
+	z.steps = x.steps + y.steps;
+
+	T ax = sqrt(x.ar * x.ar + x.ai * x.ai);
+	T bx = sqrt(x.br * x.br + x.bi * x.bi);
+	T ry = sqrt(y.r2) - bx * max_dc;
+	T r = ax > T(0.0) ? std::min(sqrt(x.r2), ry / ax) : T(0.0);
+	bool usable = r > T(0.0) && isfinite(r) && isfinite(z.ar) && isfinite(z.ai) && isfinite(z.br) && isfinite(z.bi);
+	z.r2 = usable ? r * r : T(0.0);
+	return z;
+}
+
+template <class T>
+void BlaTable<T>::build(const ReferenceOrbit& orbit, T max_dc) {
+	using std::sqrt;
+
+	clear();
+	int last = orbit.last();
+	if (last < 3) {
+		return;
+	}
+
+	std::vector<Bla> level(last - 1);
+	for (int m = 1; m < last; m++) {
+		T ar = T(2 * orbit.re[m]), ai = T(2 * orbit.im[m]);
+		T r = T(epsilon) * sqrt(ar * ar + ai * ai);
+		level[m - 1] = { ar, ai, T(1.0), T(0.0), r * r, 1 };
+	}
+	levels.push_back(std::move(level));
+
+	while (levels.back().size() > 1) {
+		const std::vector<Bla>& below = levels.back();
+		std::vector<Bla> next(below.size() / 2);
+		for (size_t i = 0; i < next.size(); i++) {
+			next[i] = merge<T>(below[2 * i], below[2 * i + 1], max_dc);
+		}
+		levels.push_back(std::move(next));
+	}
+
+	for (const Bla& bla : levels[1]) {
+		reach2 = std::max(reach2, bla.r2);
+	}
+}
+
+template <class T>
+const typename BlaTable<T>::Bla* BlaTable<T>::lookup(int n, const T& dnorm, int limit) const {
+	if (n < 1 || levels.empty()) {
+		return nullptr;
+	}
+
+	// A longer run starting at the same iteration is never valid for a larger |d| than a shorter one,
+	// so climb from two steps and stop at the first level that no longer fits.
+	unsigned int start = (unsigned int)(n - 1);
+	const Bla* best = nullptr;
+	for (size_t k = 1; k < levels.size(); k++) {
+		unsigned int step = 1u << k;
+		if (start % step != 0 || start / step >= levels[k].size()) {
+			break;
+		}
+		const Bla& bla = levels[k][start / step];
+		if (n + bla.steps > limit || !(dnorm < bla.r2)) {
+			break;
+		}
+		best = &bla;
+	}
+	return best;
+}
+
+template class BlaTable<double>;
+template class BlaTable<FloatExp>;
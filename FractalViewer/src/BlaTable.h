@@ -0,0 +1,39 @@
+#pragma once
+
+#include "FloatExp.h"
+#include "ReferenceOrbit.h"
+
+#include <vector>
+
+// Bilinear approximations d -> A d + B dc of runs of the perturbation recurrence.
+// Level k holds runs of 2^k steps starting at iterations 1, 1 + 2^k, 1 + 2 * 2^k, ...
+// and a run may be taken while |d| stays below its validity radius.
+// T is double, or FloatExp when the deltas fall below double range.
+template <class T>
+class BlaTable {
+public:
+	// Relative size of the dropped d^2 term that is still treated as exact
+	static constexpr double epsilon = 1.0 / 9007199254740992.0;
+
+	struct Bla {
+		T ar, ai;
+		T br, bi;
+		T r2;
+		int steps;
+	};
+
+	// max_dc bounds |dc| over every pixel evaluated against the orbit
+	void build(const ReferenceOrbit& orbit, T max_dc);
+	void clear() { levels.clear(); reach2 = T(0.0); }
+
+	// No run is valid once |d|^2 reaches this, so callers can skip lookup() entirely
+	const T& reach() const { return reach2; }
+
+	// Longest run of two or more steps starting at iteration n that is valid for |d|^2 = dnorm
+	// and ends at or before iteration limit; nullptr when single steps have to be taken.
+	const Bla* lookup(int n, const T& dnorm, int limit) const;
+
+private:
+	std::vector<std::vector<Bla>> levels;
+	T reach2 = T(0.0);
+};
@@ -0,0 +1,78 @@
+#include "BoundaryTrace.h"
+
+void BoundaryTracer::queue(unsigned int x, unsigned int y) {
+	uint8_t& s = state[(y - tile.y0) * (tile.x1 - tile.x0) + (x - tile.x0)];
+	if (s == Untouched) {
+		s = Queued;
+		next.push_back(y * width + x);
+	}
+}
+
+void BoundaryTracer::queueNeighbours(unsigned int x, unsigned int y) {
+	if (x > tile.x0) {
+		queue(x - 1, y);
+	}
+	if (x + 1 < tile.x1) {
+		queue(x + 1, y);
+	}
+	if (y > tile.y0) {
+		queue(x, y - 1);
+	}
+	if (y + 1 < tile.y1) {
+		queue(x, y + 1);
+	}
+}
+
+void BoundaryTracer::traceTile(const Kernel& kernel, const View& view, Frame& frame, const Tile& tile) {
+	this->tile = tile;
+	width = view.width;
+	unsigned int w = tile.x1 - tile.x0, h = tile.y1 - tile.y0;
+	state.assign((size_t)w * h, Untouched);
+	next.clear();
+
+	for (unsigned int x = tile.x0; x < tile.x1; x++) {
+		queue(x, tile.y0);
+		queue(x, tile.y1 - 1);
+	}
+	for (unsigned int y = tile.y0; y < tile.y1; y++) {
+		queue(tile.x0, y);
+		queue(tile.x1 - 1, y);
+	}
+
+	while (!next.empty()) {
+		wave.swap(next);
+		next.clear();
+		kernel.evaluate(view, frame, wave.data(), wave.size());
+		for (unsigned int pixel : wave) {
+			state[(pixel / width - tile.y0) * w + (pixel % width - tile.x0)] = Done;
+		}
+
+		// A pixel next to an evaluated pixel of another band lies on a contour; keep following it
+		// from both sides
+		for (unsigned int pixel : wave) {
+			unsigned int x = pixel % width, y = pixel / width;
+			int iters = frame.iterations[pixel];
+			const int dx[4] = { -1, 1, 0, 0 };
+			const int dy[4] = { 0, 0, -1, 1 };
+			for (int k = 0; k < 4; k++) {
+				unsigned int nx = x + dx[k], ny = y + dy[k];
+				if (nx < tile.x0 || nx >= tile.x1 || ny < tile.y0 || ny >= tile.y1) {
+					continue;
+				}
+				if (state[(ny - tile.y0) * w + (nx - tile.x0)] == Done && frame.iterations[ny * width + nx] != iters) {
+					queueNeighbours(x, y);
+					queueNeighbours(nx, ny);
+				}
+			}
+		}
+	}
+
+	// The left column is on the tile border, so every untouched pixel has a finished left neighbour
+	for (unsigned int y = tile.y0; y < tile.y1; y++) {
+		for (unsigned int x = tile.x0 + 1; x < tile.x1; x++) {
+			if (state[(y - tile.y0) * w + (x - tile.x0)] == Untouched) {
+				frame.copyResult(y * width + x, y * width + x - 1);
+			}
+		}
+	}
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+#include "Kernel.h"
+#include "TileScheduler.h"
+
+#include <cstdint>
+#include <vector>
+
+// Boundary tracing: starting from the tile border, a pixel's neighbours are only evaluated when it
+// borders a pixel with a different iteration count, so evaluation follows the contours of the
+// iteration bands. Whatever the contours enclose is filled from its left neighbour afterwards.
+// Escaped bands are filled with one flat color, so this trades the smooth gradient for speed.
+class BoundaryTracer {
+public:
+	void traceTile(const Kernel& kernel, const View& view, Frame& frame, const Tile& tile);
+
+private:
+	enum : uint8_t { Untouched, Queued, Done };
+
+	void queue(unsigned int x, unsigned int y);
+	void queueNeighbours(unsigned int x, unsigned int y);
+
+	Tile tile = {};
+	unsigned int width = 0;
+	std::vector<uint8_t> state;
+	// Evaluated in waves so the kernel gets whole lists instead of single pixels
+	std::vector<unsigned int> wave, next;
+};
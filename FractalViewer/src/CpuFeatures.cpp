@@ -0,0 +1,72 @@
+#include "CpuFeatures.h"
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#include <immintrin.h>
+#else
+#include <cpuid.h>
+#endif
+
+static void cpuid(unsigned int leaf, unsigned int subleaf, unsigned int regs[4]) {
+#if defined(_MSC_VER)
+	int r[4];
+	__cpuidex(r, (int)leaf, (int)subleaf);
+	for (int i = 0; i < 4; i++) {
+		regs[i] = (unsigned int)r[i];
+	}
+#else
+	__cpuid_count(leaf, subleaf, regs[0], regs[1], regs[2], regs[3]);
+#endif
+}
+
+static unsigned long long xgetbv0() {
+#if defined(_MSC_VER)
+	return _xgetbv(0);
+#else
+	unsigned int lo, hi;
+	__asm__ volatile("xgetbv" : "=a"(lo), "=d"(hi) : "c"(0));
+	return ((unsigned long long)hi << 32) | lo;
+#endif
+}
+
+static CpuFeatures detect() {
+	CpuFeatures features;
+	unsigned int regs[4];
+	cpuid(0, 0, regs);
+	if (regs[0] < 7) {
+		return features;
+	}
+
+	cpuid(1, 0, regs);
+	bool osxsave = (regs[2] & (1u << 27)) != 0;
+	bool avx = (regs[2] & (1u << 28)) != 0;
+	if (!osxsave || !avx) {
+		return features;
+	}
+
+	// The OS has to save the YMM (and for AVX-512 the opmask/ZMM) state across context switches
+	unsigned long long xcr0 = xgetbv0();
+	bool ymmState = (xcr0 & 0x6) == 0x6;
+	bool zmmState = (xcr0 & 0xe6) == 0xe6;
+
+	cpuid(7, 0, regs);
+	features.avx2 = ymmState && (regs[1] & (1u << 5)) != 0;
+	features.avx512f = zmmState && (regs[1] & (1u << 16)) != 0;
+	return features;
+}
+
+const CpuFeatures& cpuFeatures() {
+	static const CpuFeatures features = detect();
+	return features;
+}
+
+KernelIsa bestKernelIsa() {
+	const CpuFeatures& features = cpuFeatures();
+	if (features.avx512f) {
+		return KernelIsa::Avx512;
+	}
+	if (features.avx2) {
+		return KernelIsa::Avx2;
+	}
+	return KernelIsa::Scalar;
+}
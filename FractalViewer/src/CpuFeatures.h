@@ -0,0 +1,11 @@
+#pragma once
+
+#include "Kernel.h"
+
+struct CpuFeatures {
+	bool avx2 = false;
+	bool avx512f = false;
+};
+
+const CpuFeatures& cpuFeatures();
+KernelIsa bestKernelIsa();
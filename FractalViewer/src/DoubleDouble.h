@@ -0,0 +1,68 @@
+#pragma once
+
+// Unevaluated sum hi + lo of two doubles with |lo| <= ulp(hi) / 2, about 106 bits of mantissa.
+// Products use Dekker's split rather than fma so results don't depend on the target ISA.
+struct DoubleDouble {
+	double hi = 0.0, lo = 0.0;
+
+	DoubleDouble() = default;
+	DoubleDouble(double value) : hi(value), lo(0.0) {}
+	DoubleDouble(double hi, double lo) : hi(hi), lo(lo) {}
+
+	// a + b exactly, assuming |a| >= |b|
+	static DoubleDouble quickTwoSum(double a, double b) {
+		double s = a + b;
+		return { s, b - (s - a) };
+	}
+
+	// a + b exactly
+	static DoubleDouble twoSum(double a, double b) {
+		double s = a + b;
+		double v = s - a;
+		return { s, (a - (s - v)) + (b - v) };
+	}
+
+	// a * b exactly
+	static DoubleDouble twoProd(double a, double b) {
+		double p = a * b;
+		double ah, al, bh, bl;
+		split(a, ah, al);
+		split(b, bh, bl);
+		return { p, ((ah * bh - p) + ah * bl + al * bh) + al * bl };
+	}
+
+	friend DoubleDouble operator+(const DoubleDouble& a, const DoubleDouble& b) {
+		DoubleDouble s = twoSum(a.hi, b.hi);
+		DoubleDouble t = twoSum(a.lo, b.lo);
+		s.lo += t.hi;
+		s = quickTwoSum(s.hi, s.lo);
+		s.lo += t.lo;
+		return quickTwoSum(s.hi, s.lo);
+	}
+
+	friend DoubleDouble operator-(const DoubleDouble& a, const DoubleDouble& b) { return a + DoubleDouble(-b.hi, -b.lo); }
+
+	friend DoubleDouble operator*(const DoubleDouble& a, const DoubleDouble& b) {
+		DoubleDouble p = twoProd(a.hi, b.hi);
+		p.lo += a.hi * b.lo + a.lo * b.hi;
+		return quickTwoSum(p.hi, p.lo);
+	}
+
+	DoubleDouble sqr() const {
+		DoubleDouble p = twoProd(hi, hi);
+		p.lo += 2.0 * hi * lo;
+		return quickTwoSum(p.hi, p.lo);
+	}
+
+	// Exact multiplication by two
+	DoubleDouble twice() const { return { 2.0 * hi, 2.0 * lo }; }
+
+	double toDouble() const { return hi + lo; }
+
+private:
+	static void split(double a, double& hi, double& lo) {
+		double t = 134217729.0 * a;
+		hi = t - (t - a);
+		lo = a - hi;
+	}
+};
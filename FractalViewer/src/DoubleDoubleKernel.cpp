@@ -0,0 +1,437 @@
+#include "DoubleDoubleKernel.h"
+#include "MandelbrotKernel.h"
+
+#include <immintrin.h>
+
+// GCC would otherwise fuse the vector mul/add pairs into fma once AVX-512 is enabled and the lanes
+// would stop matching the scalar path
+#if defined(__GNUC__)
+#define TARGET_AVX2 __attribute__((target("avx2"), optimize("fp-contract=off")))
+#define TARGET_AVX512 __attribute__((target("avx512f"), optimize("fp-contract=off")))
+#else
+#define TARGET_AVX2
+#define TARGET_AVX512
+#endif
+
+namespace {
+
+DoubleDouble toDoubleDouble(const BigFixed& x) {
+	double hi = x.toDouble();
+	double lo = (x - BigFixed(hi, x.fracLimbs())).toDouble();
+	return DoubleDouble::quickTwoSum(hi, lo);
+}
+
+struct Point {
+	DoubleDouble re, im, re2, im2;
+	int iters = 0;
+};
+
+// Distance from z to a saved point. Close values subtract exactly in hi, so the lo parts carry the rest.
+inline double distance2(const DoubleDouble& re, const DoubleDouble& im, const DoubleDouble& save_re, const DoubleDouble& save_im) {
+	double dr = (re.hi - save_re.hi) + (re.lo - save_re.lo);
+	double di = (im.hi - save_im.hi) + (im.lo - save_im.lo);
+	return dr * dr + di * di;
+}
+
+// One iteration z = z^2 + c with the squares of the new z kept for the escape test
+inline void step(Point& z, const DoubleDouble& cre, const DoubleDouble& cim) {
+	z.im = (z.re * z.im).twice() + cim;
+	z.re = z.re2 - z.im2 + cre;
+	z.re2 = z.re.sqr();
+	z.im2 = z.im.sqr();
+	z.iters++;
+}
+
+// interior is set when the cycle check stopped z early; returns the iterations z ran
+int finish(const View& view, Frame& frame, size_t index, Point& z, const DoubleDouble& cre, const DoubleDouble& cim, bool interior) {
+	if (interior || z.iters >= view.max_iters) {
+		frame.setInterior(index, view.max_iters);
+		return z.iters;
+	}
+	step(z, cre, cim);
+	frame.setEscaped(index, z.iters, z.re2.hi + z.im2.hi);
+	return z.iters;
+}
+
+// Pixel bookkeeping for the vector loops, like SimdKernel's but with hi and lo planes per value.
+template <int N>
+struct Lanes {
+	alignas(64) double cre_hi[N], cre_lo[N], cim_hi[N], cim_lo[N];
+	alignas(64) double re_hi[N], re_lo[N], im_hi[N], im_lo[N];
+	alignas(64) double re2_hi[N], re2_lo[N], im2_hi[N], im2_lo[N];
+	alignas(64) double iters[N];
+	// Brent cycle detection, checked every periodicity_interval trips as in SimdKernel
+	alignas(64) double save_re_hi[N], save_re_lo[N], save_im_hi[N], save_im_lo[N], next_save[N];
+	size_t index[N];
+	int busy = 0;
+	uint64_t iterations = 0;
+
+	const View& view;
+	Frame& frame;
+	const unsigned int* pixels;
+	size_t count;
+	size_t next = 0;
+	const DoubleDouble& center_re;
+	const DoubleDouble& center_im;
+	double period_tolerance2;
+
+	Lanes(const View& view, Frame& frame, const unsigned int* pixels, size_t count, const DoubleDouble& center_re, const DoubleDouble& center_im)
+		: view(view), frame(frame), pixels(pixels), count(count), center_re(center_re), center_im(center_im) {
+		double tolerance = periodicityTolerance(view, DoubleDoubleKernel::periodicity_resolution);
+		period_tolerance2 = tolerance * tolerance;
+		for (int lane = 0; lane < N; lane++) {
+			refill(lane);
+		}
+	}
+
+	void clear(int lane) {
+		re_hi[lane] = re_lo[lane] = im_hi[lane] = im_lo[lane] = 0.0;
+		re2_hi[lane] = re2_lo[lane] = im2_hi[lane] = im2_lo[lane] = iters[lane] = 0.0;
+		save_re_hi[lane] = save_re_lo[lane] = save_im_hi[lane] = save_im_lo[lane] = 0.0;
+		next_save[lane] = MandelbrotKernel::periodicity_interval;
+	}
+
+	void refill(int lane) {
+		while (next < count) {
+			unsigned int pixel = pixels[next++];
+			DoubleDouble x = center_re + view.offsetRe(pixel % frame.width);
+			DoubleDouble y = center_im + view.offsetIm(pixel / frame.width);
+			if (MandelbrotKernel::inMainComponents(x.hi, y.hi)) {
+				frame.setInterior(pixel, view.max_iters);
+				continue;
+			}
+			cre_hi[lane] = x.hi;
+			cre_lo[lane] = x.lo;
+			cim_hi[lane] = y.hi;
+			cim_lo[lane] = y.lo;
+			clear(lane);
+			index[lane] = pixel;
+			busy |= 1 << lane;
+			return;
+		}
+		// Parked lanes iterate c = 0, which never escapes
+		cre_hi[lane] = cre_lo[lane] = cim_hi[lane] = cim_lo[lane] = 0.0;
+		clear(lane);
+		busy &= ~(1 << lane);
+	}
+
+	void retire(int mask, int interior) {
+		for (int lane = 0; lane < N; lane++) {
+			if (mask & (1 << lane)) {
+				Point z;
+				z.re = { re_hi[lane], re_lo[lane] };
+				z.im = { im_hi[lane], im_lo[lane] };
+				z.re2 = { re2_hi[lane], re2_lo[lane] };
+				z.im2 = { im2_hi[lane], im2_lo[lane] };
+				z.iters = (int)iters[lane];
+				iterations += finish(view, frame, index[lane], z, { cre_hi[lane], cre_lo[lane] }, { cim_hi[lane], cim_lo[lane] }, (interior >> lane) & 1);
+				refill(lane);
+			}
+		}
+	}
+};
+
+// The vector helpers mirror DoubleDouble operation for operation, so every lane matches the scalar path bit for bit.
+
+struct Dd4 {
+	__m256d hi, lo;
+};
+
+TARGET_AVX2 inline Dd4 quickTwoSum4(__m256d a, __m256d b) {
+	__m256d s = _mm256_add_pd(a, b);
+	return { s, _mm256_sub_pd(b, _mm256_sub_pd(s, a)) };
+}
+
+TARGET_AVX2 inline Dd4 twoSum4(__m256d a, __m256d b) {
+	__m256d s = _mm256_add_pd(a, b);
+	__m256d v = _mm256_sub_pd(s, a);
+	return { s, _mm256_add_pd(_mm256_sub_pd(a, _mm256_sub_pd(s, v)), _mm256_sub_pd(b, v)) };
+}
+
+TARGET_AVX2 inline void split4(__m256d a, __m256d& hi, __m256d& lo) {
+	__m256d t = _mm256_mul_pd(_mm256_set1_pd(134217729.0), a);
+	hi = _mm256_sub_pd(t, _mm256_sub_pd(t, a));
+	lo = _mm256_sub_pd(a, hi);
+}
+
+TARGET_AVX2 inline Dd4 twoProd4(__m256d a, __m256d b) {
+	__m256d p = _mm256_mul_pd(a, b);
+	__m256d ah, al, bh, bl;
+	split4(a, ah, al);
+	split4(b, bh, bl);
+	__m256d e = _mm256_add_pd(_mm256_add_pd(_mm256_sub_pd(_mm256_mul_pd(ah, bh), p), _mm256_mul_pd(ah, bl)), _mm256_mul_pd(al, bh));
+	return { p, _mm256_add_pd(e, _mm256_mul_pd(al, bl)) };
+}
+
+TARGET_AVX2 inline Dd4 add4(const Dd4& a, const Dd4& b) {
+	Dd4 s = twoSum4(a.hi, b.hi);
+	Dd4 t = twoSum4(a.lo, b.lo);
+	s = quickTwoSum4(s.hi, _mm256_add_pd(s.lo, t.hi));
+	return quickTwoSum4(s.hi, _mm256_add_pd(s.lo, t.lo));
+}
+
+TARGET_AVX2 inline Dd4 sub4(const Dd4& a, const Dd4& b) {
+	const __m256d sign = _mm256_set1_pd(-0.0);
+	return add4(a, { _mm256_xor_pd(b.hi, sign), _mm256_xor_pd(b.lo, sign) });
+}
+
+TARGET_AVX2 inline Dd4 mul4(const Dd4& a, const Dd4& b) {
+	Dd4 p = twoProd4(a.hi, b.hi);
+	__m256d cross = _mm256_add_pd(_mm256_mul_pd(a.hi, b.lo), _mm256_mul_pd(a.lo, b.hi));
+	return quickTwoSum4(p.hi, _mm256_add_pd(p.lo, cross));
+}
+
+TARGET_AVX2 inline Dd4 sqr4(const Dd4& a) {
+	Dd4 p = twoProd4(a.hi, a.hi);
+	__m256d cross = _mm256_mul_pd(_mm256_mul_pd(_mm256_set1_pd(2.0), a.hi), a.lo);
+	return quickTwoSum4(p.hi, _mm256_add_pd(p.lo, cross));
+}
+
+TARGET_AVX2 inline Dd4 twice4(const Dd4& a) {
+	return { _mm256_add_pd(a.hi, a.hi), _mm256_add_pd(a.lo, a.lo) };
+}
+
+TARGET_AVX2 uint64_t evaluateAvx2(const View& view, Frame& frame, const unsigned int* pixels, size_t count, const DoubleDouble& center_re, const DoubleDouble& center_im) {
+	Lanes<4> lanes(view, frame, pixels, count, center_re, center_im);
+	const __m256d one = _mm256_set1_pd(1.0);
+	const __m256d four = _mm256_set1_pd(4.0);
+	const __m256d maxIters = _mm256_set1_pd((double)view.max_iters);
+	const __m256d two = _mm256_set1_pd(2.0);
+	const __m256d tolerance2 = _mm256_set1_pd(lanes.period_tolerance2);
+	unsigned int trips = 0;
+
+	while (lanes.busy) {
+		Dd4 cre = { _mm256_load_pd(lanes.cre_hi), _mm256_load_pd(lanes.cre_lo) };
+		Dd4 cim = { _mm256_load_pd(lanes.cim_hi), _mm256_load_pd(lanes.cim_lo) };
+		Dd4 re = { _mm256_load_pd(lanes.re_hi), _mm256_load_pd(lanes.re_lo) };
+		Dd4 im = { _mm256_load_pd(lanes.im_hi), _mm256_load_pd(lanes.im_lo) };
+		Dd4 re2 = { _mm256_load_pd(lanes.re2_hi), _mm256_load_pd(lanes.re2_lo) };
+		Dd4 im2 = { _mm256_load_pd(lanes.im2_hi), _mm256_load_pd(lanes.im2_lo) };
+		__m256d iters = _mm256_load_pd(lanes.iters);
+		Dd4 saveRe = { _mm256_load_pd(lanes.save_re_hi), _mm256_load_pd(lanes.save_re_lo) };
+		Dd4 saveIm = { _mm256_load_pd(lanes.save_im_hi), _mm256_load_pd(lanes.save_im_lo) };
+		__m256d nextSave = _mm256_load_pd(lanes.next_save);
+		__m256d interior = _mm256_setzero_pd();
+
+		int done;
+		do {
+			im = add4(twice4(mul4(re, im)), cim);
+			re = add4(sub4(re2, im2), cre);
+			re2 = sqr4(re);
+			im2 = sqr4(im);
+			iters = _mm256_add_pd(iters, one);
+
+			__m256d escaped = _mm256_cmp_pd(_mm256_add_pd(re2.hi, im2.hi), four, _CMP_GT_OQ);
+			if (++trips % MandelbrotKernel::periodicity_interval == 0) {
+				__m256d dr = _mm256_add_pd(_mm256_sub_pd(re.hi, saveRe.hi), _mm256_sub_pd(re.lo, saveRe.lo));
+				__m256d di = _mm256_add_pd(_mm256_sub_pd(im.hi, saveIm.hi), _mm256_sub_pd(im.lo, saveIm.lo));
+				__m256d periodic = _mm256_cmp_pd(_mm256_add_pd(_mm256_mul_pd(dr, dr), _mm256_mul_pd(di, di)), tolerance2, _CMP_LT_OQ);
+				interior = _mm256_andnot_pd(escaped, periodic);
+				__m256d save = _mm256_cmp_pd(iters, nextSave, _CMP_GE_OQ);
+				saveRe = { _mm256_blendv_pd(saveRe.hi, re.hi, save), _mm256_blendv_pd(saveRe.lo, re.lo, save) };
+				saveIm = { _mm256_blendv_pd(saveIm.hi, im.hi, save), _mm256_blendv_pd(saveIm.lo, im.lo, save) };
+				nextSave = _mm256_blendv_pd(nextSave, _mm256_mul_pd(nextSave, two), save);
+			}
+			__m256d capped = _mm256_cmp_pd(iters, maxIters, _CMP_GE_OQ);
+			done = _mm256_movemask_pd(_mm256_or_pd(_mm256_or_pd(escaped, capped), interior)) & lanes.busy;
+		} while (!done);
+
+		_mm256_store_pd(lanes.re_hi, re.hi);
+		_mm256_store_pd(lanes.re_lo, re.lo);
+		_mm256_store_pd(lanes.im_hi, im.hi);
+		_mm256_store_pd(lanes.im_lo, im.lo);
+		_mm256_store_pd(lanes.re2_hi, re2.hi);
+		_mm256_store_pd(lanes.re2_lo, re2.lo);
+		_mm256_store_pd(lanes.im2_hi, im2.hi);
+		_mm256_store_pd(lanes.im2_lo, im2.lo);
+		_mm256_store_pd(lanes.iters, iters);
+		_mm256_store_pd(lanes.save_re_hi, saveRe.hi);
+		_mm256_store_pd(lanes.save_re_lo, saveRe.lo);
+		_mm256_store_pd(lanes.save_im_hi, saveIm.hi);
+		_mm256_store_pd(lanes.save_im_lo, saveIm.lo);
+		_mm256_store_pd(lanes.next_save, nextSave);
+		lanes.retire(done, _mm256_movemask_pd(interior));
+	}
+	return lanes.iterations;
+}
+
+struct Dd8 {
+	__m512d hi, lo;
+};
+
+TARGET_AVX512 inline Dd8 quickTwoSum8(__m512d a, __m512d b) {
+	__m512d s = _mm512_add_pd(a, b);
+	return { s, _mm512_sub_pd(b, _mm512_sub_pd(s, a)) };
+}
+
+TARGET_AVX512 inline Dd8 twoSum8(__m512d a, __m512d b) {
+	__m512d s = _mm512_add_pd(a, b);
+	__m512d v = _mm512_sub_pd(s, a);
+	return { s, _mm512_add_pd(_mm512_sub_pd(a, _mm512_sub_pd(s, v)), _mm512_sub_pd(b, v)) };
+}
+
+// AVX-512F always has fma, which gives the same exact error term as the split in one instruction
+TARGET_AVX512 inline Dd8 twoProd8(__m512d a, __m512d b) {
+	__m512d p = _mm512_mul_pd(a, b);
+	return { p, _mm512_fmsub_pd(a, b, p) };
+}
+
+TARGET_AVX512 inline Dd8 add8(const Dd8& a, const Dd8& b) {
+	Dd8 s = twoSum8(a.hi, b.hi);
+	Dd8 t = twoSum8(a.lo, b.lo);
+	s = quickTwoSum8(s.hi, _mm512_add_pd(s.lo, t.hi));
+	return quickTwoSum8(s.hi, _mm512_add_pd(s.lo, t.lo));
+}
+
+TARGET_AVX512 inline Dd8 sub8(const Dd8& a, const Dd8& b) {
+	const __m512i sign = _mm512_set1_epi64((long long)0x8000000000000000ull);
+	__m512d hi = _mm512_castsi512_pd(_mm512_xor_si512(_mm512_castpd_si512(b.hi), sign));
+	__m512d lo = _mm512_castsi512_pd(_mm512_xor_si512(_mm512_castpd_si512(b.lo), sign));
+	return add8(a, { hi, lo });
+}
+
+TARGET_AVX512 inline Dd8 mul8(const Dd8& a, const Dd8& b) {
+	Dd8 p = twoProd8(a.hi, b.hi);
+	__m512d cross = _mm512_add_pd(_mm512_mul_pd(a.hi, b.lo), _mm512_mul_pd(a.lo, b.hi));
+	return quickTwoSum8(p.hi, _mm512_add_pd(p.lo, cross));
+}
+
+TARGET_AVX512 inline Dd8 sqr8(const Dd8& a) {
+	Dd8 p = twoProd8(a.hi, a.hi);
+	__m512d cross = _mm512_mul_pd(_mm512_mul_pd(_mm512_set1_pd(2.0), a.hi), a.lo);
+	return quickTwoSum8(p.hi, _mm512_add_pd(p.lo, cross));
+}
+
+TARGET_AVX512 inline Dd8 twice8(const Dd8& a) {
+	return { _mm512_add_pd(a.hi, a.hi), _mm512_add_pd(a.lo, a.lo) };
+}
+
+TARGET_AVX512 uint64_t evaluateAvx512(const View& view, Frame& frame, const unsigned int* pixels, size_t count, const DoubleDouble& center_re, const DoubleDouble& center_im) {
+	Lanes<8> lanes(view, frame, pixels, count, center_re, center_im);
+	const __m512d one = _mm512_set1_pd(1.0);
+	const __m512d four = _mm512_set1_pd(4.0);
+	const __m512d maxIters = _mm512_set1_pd((double)view.max_iters);
+	const __m512d two = _mm512_set1_pd(2.0);
+	const __m512d tolerance2 = _mm512_set1_pd(lanes.period_tolerance2);
+	unsigned int trips = 0;
+
+	while (lanes.busy) {
+		Dd8 cre = { _mm512_load_pd(lanes.cre_hi), _mm512_load_pd(lanes.cre_lo) };
+		Dd8 cim = { _mm512_load_pd(lanes.cim_hi), _mm512_load_pd(lanes.cim_lo) };
+		Dd8 re = { _mm512_load_pd(lanes.re_hi), _mm512_load_pd(lanes.re_lo) };
+		Dd8 im = { _mm512_load_pd(lanes.im_hi), _mm512_load_pd(lanes.im_lo) };
+		Dd8 re2 = { _mm512_load_pd(lanes.re2_hi), _mm512_load_pd(lanes.re2_lo) };
+		Dd8 im2 = { _mm512_load_pd(lanes.im2_hi), _mm512_load_pd(lanes.im2_lo) };
+		__m512d iters = _mm512_load_pd(lanes.iters);
+		Dd8 saveRe = { _mm512_load_pd(lanes.save_re_hi), _mm512_load_pd(lanes.save_re_lo) };
+		Dd8 saveIm = { _mm512_load_pd(lanes.save_im_hi), _mm512_load_pd(lanes.save_im_lo) };
+		__m512d nextSave = _mm512_load_pd(lanes.next_save);
+		__mmask8 interior = 0;
+
+		int done;
+		do {
+			im = add8(twice8(mul8(re, im)), cim);
+			re = add8(sub8(re2, im2), cre);
+			re2 = sqr8(re);
+			im2 = sqr8(im);
+			iters = _mm512_add_pd(iters, one);
+
+			__mmask8 escaped = _mm512_cmp_pd_mask(_mm512_add_pd(re2.hi, im2.hi), four, _CMP_GT_OQ);
+			if (++trips % MandelbrotKernel::periodicity_interval == 0) {
+				__m512d dr = _mm512_add_pd(_mm512_sub_pd(re.hi, saveRe.hi), _mm512_sub_pd(re.lo, saveRe.lo));
+				__m512d di = _mm512_add_pd(_mm512_sub_pd(im.hi, saveIm.hi), _mm512_sub_pd(im.lo, saveIm.lo));
+				interior = _mm512_cmp_pd_mask(_mm512_add_pd(_mm512_mul_pd(dr, dr), _mm512_mul_pd(di, di)), tolerance2, _CMP_LT_OQ) & ~escaped;
+				__mmask8 save = _mm512_cmp_pd_mask(iters, nextSave, _CMP_GE_OQ);
+				saveRe = { _mm512_mask_blend_pd(save, saveRe.hi, re.hi), _mm512_mask_blend_pd(save, saveRe.lo, re.lo) };
+				saveIm = { _mm512_mask_blend_pd(save, saveIm.hi, im.hi), _mm512_mask_blend_pd(save, saveIm.lo, im.lo) };
+				nextSave = _mm512_mask_blend_pd(save, nextSave, _mm512_mul_pd(nextSave, two));
+			}
+			__mmask8 capped = _mm512_cmp_pd_mask(iters, maxIters, _CMP_GE_OQ);
+			done = (int)(escaped | capped | interior) & lanes.busy;
+		} while (!done);
+
+		_mm512_store_pd(lanes.re_hi, re.hi);
+		_mm512_store_pd(lanes.re_lo, re.lo);
+		_mm512_store_pd(lanes.im_hi, im.hi);
+		_mm512_store_pd(lanes.im_lo, im.lo);
+		_mm512_store_pd(lanes.re2_hi, re2.hi);
+		_mm512_store_pd(lanes.re2_lo, re2.lo);
+		_mm512_store_pd(lanes.im2_hi, im2.hi);
+		_mm512_store_pd(lanes.im2_lo, im2.lo);
+		_mm512_store_pd(lanes.iters, iters);
+		_mm512_store_pd(lanes.save_re_hi, saveRe.hi);
+		_mm512_store_pd(lanes.save_re_lo, saveRe.lo);
+		_mm512_store_pd(lanes.save_im_hi, saveIm.hi);
+		_mm512_store_pd(lanes.save_im_lo, saveIm.lo);
+		_mm512_store_pd(lanes.next_save, nextSave);
+		lanes.retire(done, interior);
+	}
+	return lanes.iterations;
+}
+
+uint64_t evaluateScalar(const View& view, Frame& frame, const unsigned int* pixels, size_t count, const DoubleDouble& center_re, const DoubleDouble& center_im) {
+	double tolerance = periodicityTolerance(view, DoubleDoubleKernel::periodicity_resolution);
+	double tolerance2 = tolerance * tolerance;
+	uint64_t iterations = 0;
+	for (size_t i = 0; i < count; i++) {
+		unsigned int pixel = pixels[i];
+		DoubleDouble cre = center_re + view.offsetRe(pixel % frame.width);
+		DoubleDouble cim = center_im + view.offsetIm(pixel / frame.width);
+		if (MandelbrotKernel::inMainComponents(cre.hi, cim.hi)) {
+			frame.setInterior(pixel, view.max_iters);
+			continue;
+		}
+
+		Point z;
+		DoubleDouble save_re, save_im;
+		int next_save = MandelbrotKernel::periodicity_interval;
+		bool interior = false;
+		while (z.re2.hi + z.im2.hi <= 4 && z.iters < view.max_iters) {
+			step(z, cre, cim);
+			if (z.iters % MandelbrotKernel::periodicity_interval == 0) {
+				if (distance2(z.re, z.im, save_re, save_im) < tolerance2 && z.re2.hi + z.im2.hi <= 4) {
+					interior = true;
+					break;
+				}
+				if (z.iters >= next_save) {
+					save_re = z.re;
+					save_im = z.im;
+					next_save *= 2;
+				}
+			}
+		}
+		iterations += finish(view, frame, pixel, z, cre, cim, interior);
+	}
+	return iterations;
+}
+
+}
+
+DoubleDoubleKernel::DoubleDoubleKernel(KernelIsa isa) : isa(isa) {}
+
+const char* DoubleDoubleKernel::name() const {
+	switch (isa) {
+	case KernelIsa::Avx512:
+		return "dd-avx512";
+	case KernelIsa::Avx2:
+		return "dd-avx2";
+	default:
+		return "dd-scalar";
+	}
+}
+
+void DoubleDoubleKernel::prepare(const View& view) {
+	center_re = toDoubleDouble(view.pos_x);
+	center_im = toDoubleDouble(view.pos_y);
+}
+
+uint64_t DoubleDoubleKernel::evaluate(const View& view, Frame& frame, const unsigned int* pixels, size_t count) const {
+	switch (isa) {
+	case KernelIsa::Avx512:
+		return evaluateAvx512(view, frame, pixels, count, center_re, center_im);
+	case KernelIsa::Avx2:
+		return evaluateAvx2(view, frame, pixels, count, center_re, center_im);
+	default:
+		return evaluateScalar(view, frame, pixels, count, center_re, center_im);
+	}
+}
@@ -0,0 +1,23 @@
+#pragma once
+
+#include "DoubleDouble.h"
+#include "Kernel.h"
+
+// Escape-time kernel in double-double arithmetic for zooms where double pixels merge but a
+// perturbation reference isn't needed yet. Iterates 1, 4 (AVX2) or 8 (AVX-512) pixels at once.
+class DoubleDoubleKernel : public Kernel {
+public:
+	// Smallest orbit distance double-double tells apart for |z| around 1
+	static constexpr double periodicity_resolution = 1e-30;
+
+	explicit DoubleDoubleKernel(KernelIsa isa);
+
+	const char* name() const override;
+	// Rounds the view center to double-double
+	void prepare(const View& view) override;
+	uint64_t evaluate(const View& view, Frame& frame, const unsigned int* pixels, size_t count) const override;
+
+private:
+	KernelIsa isa;
+	DoubleDouble center_re, center_im;
+};
@@ -0,0 +1,153 @@
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+
+// Double mantissa with a separate 64-bit binary exponent, value = m * 2^e with 0.5 <= |m| < 1 (or m = 0).
+// Used for perturbation deltas once the pixel size drops below what double can represent.
+class FloatExp {
+public:
+	double m = 0.0;
+	int64_t e = 0;
+
+	FloatExp() = default;
+	FloatExp(double value) : m(value), e(0) { normalize(); }
+	FloatExp(double mantissa, int64_t exponent) : m(mantissa), e(exponent) { normalize(); }
+
+	double toDouble() const {
+		if (e < -1080) {
+			return 0.0;
+		}
+		if (e > 1024) {
+			return m < 0 ? -std::numeric_limits<double>::infinity() : std::numeric_limits<double>::infinity();
+		}
+		return ldexp(m, (int)e);
+	}
+
+	// log2 of the magnitude, -infinity for zero
+	double log2Abs() const { return m == 0.0 ? -std::numeric_limits<double>::infinity() : log2(fabs(m)) + (double)e; }
+
+	FloatExp operator-() const { return raw(-m, e); }
+
+	friend FloatExp operator*(const FloatExp& a, const FloatExp& b) {
+		double m = a.m * b.m;
+		// Both mantissas are in [0.5, 1) so the product needs at most one bit of renormalization
+		if (m == 0.0) {
+			return FloatExp();
+		}
+		if (fabs(m) < 0.5) {
+			return raw(m * 2.0, a.e + b.e - 1);
+		}
+		return raw(m, a.e + b.e);
+	}
+
+	friend FloatExp operator/(const FloatExp& a, const FloatExp& b) {
+		return FloatExp(a.m / b.m, a.e - b.e);
+	}
+
+	friend FloatExp operator+(const FloatExp& a, const FloatExp& b) {
+		if (a.m == 0.0) {
+			return b;
+		}
+		if (b.m == 0.0) {
+			return a;
+		}
+		int64_t diff = a.e - b.e;
+		if (diff > 64) {
+			return a;
+		}
+		if (diff < -64) {
+			return b;
+		}
+		if (diff >= 0) {
+			return FloatExp(a.m + b.m * pow2(-(int)diff), a.e);
+		}
+		return FloatExp(a.m * pow2((int)diff) + b.m, b.e);
+	}
+
+	friend FloatExp operator-(const FloatExp& a, const FloatExp& b) { return a + (-b); }
+
+	FloatExp& operator+=(const FloatExp& b) { return *this = *this + b; }
+	FloatExp& operator-=(const FloatExp& b) { return *this = *this - b; }
+	FloatExp& operator*=(const FloatExp& b) { return *this = *this * b; }
+
+	// Ordering of magnitudes for non-negative values such as norms and radii
+	friend bool operator<(const FloatExp& a, const FloatExp& b) {
+		if (a.m == 0.0 || b.m == 0.0) {
+			return a.m < b.m;
+		}
+		if ((a.m < 0) != (b.m < 0)) {
+			return a.m < 0;
+		}
+		if (a.e != b.e) {
+			return (a.e < b.e) != (a.m < 0);
+		}
+		return a.m < b.m;
+	}
+	friend bool operator>(const FloatExp& a, const FloatExp& b) { return b < a; }
+	friend bool operator<=(const FloatExp& a, const FloatExp& b) { return !(b < a); }
+	friend bool operator>=(const FloatExp& a, const FloatExp& b) { return !(a < b); }
+
+private:
+	static FloatExp raw(double m, int64_t e) {
+		FloatExp x;
+		x.m = m;
+		x.e = e;
+		return x;
+	}
+
+	// 2^k for -1022 <= k <= 1023, built directly from the exponent bits
+	static double pow2(int k) {
+		uint64_t bits = (uint64_t)(k + 1023) << 52;
+		double value;
+		memcpy(&value, &bits, sizeof(value));
+		return value;
+	}
+
+	void normalize() {
+		uint64_t bits;
+		memcpy(&bits, &m, sizeof(bits));
+		int biased = (int)((bits >> 52) & 0x7ff);
+		if (biased == 0) {
+			if (m == 0.0) {
+				e = 0;
+				return;
+			}
+			int shift;
+			m = frexp(m, &shift);
+			e += shift;
+			return;
+		}
+		// Infinity and NaN keep their bits, so isfinite() still sees them after an overflow
+		if (biased == 0x7ff) {
+			return;
+		}
+		e += biased - 1022;
+		bits = (bits & ~(0x7ffull << 52)) | (1022ull << 52);
+		memcpy(&m, &bits, sizeof(m));
+	}
+};
+
+inline FloatExp sqrt(const FloatExp& x) {
+	if (x.m <= 0.0) {
+		return FloatExp();
+	}
+	// Make the exponent even so it halves exactly
+	double m = (x.e & 1) ? x.m * 2.0 : x.m;
+	int64_t e = (x.e & 1) ? x.e - 1 : x.e;
+	return FloatExp(std::sqrt(m), e / 2);
+}
+
+inline bool isfinite(const FloatExp& x) {
+	return std::isfinite(x.m);
+}
+
+inline double toDouble(double x) {
+	return x;
+}
+
+inline double toDouble(const FloatExp& x) {
+	return x.toDouble();
+}
@@ -0,0 +1,171 @@
+#include "FrameStats.h"
+
+#include <algorithm>
+#include <cmath>
+
+static void atomicMax(std::atomic<uint64_t>& target, uint64_t value) {
+	uint64_t current = target.load(std::memory_order_relaxed);
+	while (value > current && !target.compare_exchange_weak(current, value, std::memory_order_relaxed)) {
+	}
+}
+
+void LatencyHistogram::record(double seconds) {
+	double us = seconds * 1e6;
+	int bucket = us <= 1.0 ? 0 : (int)(log2(us) * buckets_per_octave);
+	counts[std::min(bucket, bucket_count - 1)].fetch_add(1, std::memory_order_relaxed);
+	uint64_t ns = (uint64_t)std::max(seconds * 1e9, 0.0);
+	total_ns.fetch_add(ns, std::memory_order_relaxed);
+	atomicMax(max_ns, ns);
+}
+
+void LatencyHistogram::reset() {
+	for (std::atomic<uint64_t>& count : counts) {
+		count.store(0, std::memory_order_relaxed);
+	}
+	total_ns.store(0, std::memory_order_relaxed);
+	max_ns.store(0, std::memory_order_relaxed);
+}
+
+uint64_t LatencyHistogram::count() const {
+	uint64_t sum = 0;
+	for (const std::atomic<uint64_t>& count : counts) {
+		sum += count.load(std::memory_order_relaxed);
+	}
+	return sum;
+}
+
+double LatencyHistogram::meanSeconds() const {
+	uint64_t n = count();
+	return n > 0 ? total_ns.load(std::memory_order_relaxed) * 1e-9 / n : 0.0;
+}
+
+double LatencyHistogram::quantile(double q) const {
+	uint64_t n = count();
+	if (n == 0) {
+		return 0.0;
+	}
+	// Rank of the sample at quantile q, counted from 1
+	uint64_t rank = std::max<uint64_t>(1, (uint64_t)ceil(q * n));
+	uint64_t seen = 0;
+	for (int i = 0; i < bucket_count; i++) {
+		seen += counts[i].load(std::memory_order_relaxed);
+		if (seen >= rank) {
+			// The edge can't exceed the largest sample
+			return std::min(exp2((double)(i + 1) / buckets_per_octave) * 1e-6, maxSeconds());
+		}
+	}
+	return maxSeconds();
+}
+
+const char* FrameStats::stageName(Stage stage) {
+	switch (stage) {
+	case Stage::Frame: return "frame";
+	case Stage::Iterate: return "iterate";
+	case Stage::Color: return "color";
+	case Stage::Upload: return "upload";
+	case Stage::Present: return "present";
+	case Stage::Latency: return "latency";
+	}
+	return "unknown";
+}
+
+void FrameStats::record(Stage stage, double seconds) {
+	window.stages[(int)stage].record(seconds);
+	total.stages[(int)stage].record(seconds);
+}
+
+void FrameStats::addIterations(uint64_t iterations, double seconds) {
+	uint64_t ns = (uint64_t)std::max(seconds * 1e9, 0.0);
+	for (Counters* counters : { &window, &total }) {
+		counters->iterations.fetch_add(iterations, std::memory_order_relaxed);
+		counters->iterate_ns.fetch_add(ns, std::memory_order_relaxed);
+	}
+}
+
+void FrameStats::setBudget(int iters, double fraction) {
+	max_iters.store(iters, std::memory_order_relaxed);
+	cap_fraction.store(fraction, std::memory_order_relaxed);
+}
+
+void FrameStats::summarize(const Counters& counters, Summary& summary) const {
+	for (int i = 0; i < stage_count; i++) {
+		const LatencyHistogram& histogram = counters.stages[i];
+		summary.stages[i] = { histogram.count(), histogram.meanSeconds(), histogram.quantile(0.5),
+			histogram.quantile(0.95), histogram.quantile(0.99), histogram.maxSeconds() };
+	}
+	summary.iterations = counters.iterations.load(std::memory_order_relaxed);
+	uint64_t ns = counters.iterate_ns.load(std::memory_order_relaxed);
+	summary.iteration_rate = ns > 0 ? summary.iterations / (ns * 1e-9) : 0.0;
+	summary.max_iters = max_iters.load(std::memory_order_relaxed);
+	summary.cap_fraction = cap_fraction.load(std::memory_order_relaxed);
+}
+
+FrameStats::Summary FrameStats::takeWindow(double time) {
+	Summary summary;
+	summary.time = time;
+	summary.seconds = time - window_start;
+	summarize(window, summary);
+	for (LatencyHistogram& histogram : window.stages) {
+		histogram.reset();
+	}
+	window.iterations.store(0, std::memory_order_relaxed);
+	window.iterate_ns.store(0, std::memory_order_relaxed);
+	window_start = time;
+	return summary;
+}
+
+FrameStats::Summary FrameStats::session(double time) const {
+	Summary summary;
+	summary.time = time;
+	summary.seconds = time;
+	summarize(total, summary);
+	return summary;
+}
+
+bool StatsStream::open(const std::string& path) {
+	size_t dot = path.rfind('.');
+	std::string extension = dot == std::string::npos ? "" : path.substr(dot);
+	json = extension == ".json" || extension == ".jsonl";
+	out.open(path);
+	if (!out.is_open()) {
+		return false;
+	}
+	if (!json) {
+		out << "scope,time,seconds,iterations,iterations_per_second,max_iters,cap_fraction";
+		for (int i = 0; i < FrameStats::stage_count; i++) {
+			const char* name = FrameStats::stageName((FrameStats::Stage)i);
+			out << ',' << name << "_count," << name << "_mean_ms," << name << "_p50_ms," << name << "_p95_ms,"
+				<< name << "_p99_ms," << name << "_max_ms";
+		}
+		out << '\n';
+	}
+	return true;
+}
+
+void StatsStream::write(const FrameStats::Summary& summary, const char* scope) {
+	if (!out.is_open()) {
+		return;
+	}
+	if (json) {
+		out << "{\"scope\":\"" << scope << "\",\"time\":" << summary.time << ",\"seconds\":" << summary.seconds
+			<< ",\"iterations\":" << summary.iterations << ",\"iterations_per_second\":" << summary.iteration_rate
+			<< ",\"max_iters\":" << summary.max_iters << ",\"cap_fraction\":" << summary.cap_fraction << ",\"stages\":{";
+		for (int i = 0; i < FrameStats::stage_count; i++) {
+			const auto& stage = summary.stages[i];
+			out << (i > 0 ? "," : "") << '"' << FrameStats::stageName((FrameStats::Stage)i) << "\":{\"count\":"
+				<< stage.count << ",\"mean_ms\":" << stage.mean * 1e3 << ",\"p50_ms\":" << stage.p50 * 1e3
+				<< ",\"p95_ms\":" << stage.p95 * 1e3 << ",\"p99_ms\":" << stage.p99 * 1e3
+				<< ",\"max_ms\":" << stage.max * 1e3 << '}';
+		}
+		out << "}}\n";
+	} else {
+		out << scope << ',' << summary.time << ',' << summary.seconds << ',' << summary.iterations << ','
+			<< summary.iteration_rate << ',' << summary.max_iters << ',' << summary.cap_fraction;
+		for (const auto& stage : summary.stages) {
+			out << ',' << stage.count << ',' << stage.mean * 1e3 << ',' << stage.p50 * 1e3 << ','
+				<< stage.p95 * 1e3 << ',' << stage.p99 * 1e3 << ',' << stage.max * 1e3;
+		}
+		out << '\n';
+	}
+	out.flush();
+}
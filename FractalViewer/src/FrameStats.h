@@ -0,0 +1,100 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <fstream>
+#include <string>
+
+// Distribution of one kind of duration in log-spaced buckets, so recording a sample is one increment
+// and quantiles come out within a bucket width (about 9%). Samples may be recorded by one thread while
+// another reads or resets the histogram.
+class LatencyHistogram {
+public:
+	// Buckets span 1 us to about 2 minutes
+	static constexpr int buckets_per_octave = 8;
+	static constexpr int octaves = 27;
+	static constexpr int bucket_count = buckets_per_octave * octaves;
+
+	void record(double seconds);
+	void reset();
+
+	uint64_t count() const;
+	double meanSeconds() const;
+	double maxSeconds() const { return max_ns.load(std::memory_order_relaxed) * 1e-9; }
+	// Upper edge of the bucket holding quantile q, 0 without samples
+	double quantile(double q) const;
+
+private:
+	std::atomic<uint64_t> counts[bucket_count] = {};
+	std::atomic<uint64_t> total_ns{ 0 };
+	std::atomic<uint64_t> max_ns{ 0 };
+};
+
+// Timings of the viewer's stages. The main thread records whole frames, texture uploads and buffer
+// swaps; the render thread records, for each request it finishes, the time it spent iterating and
+// coloring it and the latency from submitting the request to its final image.
+class FrameStats {
+public:
+	enum class Stage {
+		Frame,
+		Iterate,
+		Color,
+		Upload,
+		Present,
+		Latency
+	};
+	static constexpr int stage_count = 6;
+
+	static const char* stageName(Stage stage);
+
+	void record(Stage stage, double seconds);
+	void addIterations(uint64_t iterations, double seconds);
+	// Iteration budget of the last published image and the fraction of its pixels that reached it
+	void setBudget(int max_iters, double cap_fraction);
+
+	// Statistics since the last takeWindow() or since startup
+	struct Summary {
+		double time = 0.0;
+		double seconds = 0.0;
+		struct {
+			uint64_t count;
+			double mean, p50, p95, p99, max;
+		} stages[stage_count] = {};
+		uint64_t iterations = 0;
+		// Iterations per second of iterating time, across all worker threads
+		double iteration_rate = 0.0;
+		// As last passed to setBudget()
+		int max_iters = 0;
+		double cap_fraction = 0.0;
+	};
+	// Summarizes the samples since the last call and starts a new window
+	Summary takeWindow(double time);
+	Summary session(double time) const;
+
+private:
+	struct Counters {
+		LatencyHistogram stages[stage_count];
+		std::atomic<uint64_t> iterations{ 0 };
+		std::atomic<uint64_t> iterate_ns{ 0 };
+	};
+	void summarize(const Counters& counters, Summary& summary) const;
+
+	Counters window, total;
+	double window_start = 0.0;
+	std::atomic<int> max_iters{ 0 };
+	std::atomic<double> cap_fraction{ 0.0 };
+};
+
+// Writes summaries as CSV rows or as JSON objects, one per line. The format follows the file extension:
+// .json and .jsonl give JSON, anything else CSV.
+class StatsStream {
+public:
+	bool open(const std::string& path);
+	bool isOpen() const { return out.is_open(); }
+	// scope tells apart per-window rows from the session summary written at exit
+	void write(const FrameStats::Summary& summary, const char* scope);
+
+private:
+	std::ofstream out;
+	bool json = false;
+};
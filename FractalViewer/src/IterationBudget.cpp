@@ -0,0 +1,71 @@
+#include "IterationBudget.h"
+
+void IterationBudget::probePixels(const View& view, std::vector<unsigned int>& pixels) const {
+	pixels.clear();
+	for (unsigned int y = probe_spacing / 2; y < view.height; y += probe_spacing) {
+		for (unsigned int x = probe_spacing / 2; x < view.width; x += probe_spacing) {
+			pixels.push_back(y * view.width + x);
+		}
+	}
+}
+
+int IterationBudget::choose(const Frame& frame, const std::vector<unsigned int>& pixels) {
+	int limit = probeLimit();
+	escapes.clear();
+	for (unsigned int pixel : pixels) {
+		int iters = frame.iterations[pixel];
+		if (iters >= 0 && iters < limit) {
+			escapes.push_back(iters);
+		}
+	}
+
+	// A probe that is interior everywhere says nothing about the escapes between its pixels
+	if (escapes.empty() && !crowded) {
+		changed = false;
+		return budget;
+	}
+
+	int highest = 0;
+	if (!escapes.empty()) {
+		// The very last escapes are a few pixels right at the boundary; chasing them would let the
+		// budget run away at shallow zooms
+		std::vector<int>::iterator nth = escapes.begin() + (size_t)(escape_quantile * (escapes.size() - 1));
+		std::nth_element(escapes.begin(), nth, escapes.end());
+		highest = *nth;
+	}
+
+	// The full frame has pixels closer to the boundary than any probe pixel, and they escape later
+	int target = highest * 2;
+	if (crowded) {
+		target = std::max(target, budget * 2);
+	}
+	target = (target + min_iters - 1) / min_iters * min_iters;
+	target = std::min(std::max(target, min_iters), max_iters);
+
+	// Only shrink by a good margin, so panning doesn't make the budget flicker
+	changed = target > budget || target < budget / 2;
+	if (changed) {
+		budget = target;
+	}
+	crowded = false;
+	return budget;
+}
+
+void IterationBudget::observe(const Frame& frame) {
+	size_t capped = 0, escaped = 0, late = 0;
+	for (int iters : frame.iterations) {
+		if (iters < 0) {
+			continue;
+		}
+		if (iters >= budget) {
+			capped++;
+		} else {
+			escaped++;
+			if (iters >= budget - budget / 4) {
+				late++;
+			}
+		}
+	}
+	cap_fraction = frame.iterations.empty() ? 0.0 : (double)capped / frame.iterations.size();
+	crowded = late > escaped * crowded_fraction;
+}
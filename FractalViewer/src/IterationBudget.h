@@ -0,0 +1,46 @@
+#pragma once
+
+#include "Kernel.h"
+
+#include <algorithm>
+#include <vector>
+
+// Picks View::max_iters for each frame instead of a fixed 2000. A sparse probe of the new view is
+// iterated past the current budget to see how deep its escapes go, and the finished frame reports
+// whether its full resolution still escaped close to the cap.
+class IterationBudget {
+public:
+	static constexpr int min_iters = 256;
+	static constexpr int max_iters = 1 << 22;
+	// Probe pixels are this many pixels apart in both directions
+	static constexpr unsigned int probe_spacing = 8;
+	// The probe runs this many times the current budget
+	static constexpr int probe_headroom = 2;
+	// The budget is twice the iteration count this fraction of the escaping probe pixels stay under
+	static constexpr double escape_quantile = 0.999;
+	// A finished frame with more than the remaining fraction of its escapes in the top quarter of the
+	// budget doubles the next one
+	static constexpr double crowded_fraction = 1.0 - escape_quantile;
+
+	// Iteration limit the probe has to be evaluated with
+	int probeLimit() const { return std::min(budget * probe_headroom, max_iters); }
+	// Frame indices of the probe pixels of a view
+	void probePixels(const View& view, std::vector<unsigned int>& pixels) const;
+	// Sets the budget from the probe pixels of frame, evaluated with probeLimit()
+	int choose(const Frame& frame, const std::vector<unsigned int>& pixels);
+	// Takes the statistics of a frame rendered with current()
+	void observe(const Frame& frame);
+
+	int current() const { return budget; }
+	// False while the next frame of an unchanged view would still get a different budget
+	bool settled() const { return !changed && !crowded; }
+	// Fraction of the last observed frame that ran until the budget, interior pixels included
+	double capFraction() const { return cap_fraction; }
+
+private:
+	int budget = 2000;
+	bool crowded = false;
+	bool changed = false;
+	double cap_fraction = 0.0;
+	std::vector<int> escapes;
+};
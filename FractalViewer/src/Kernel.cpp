@@ -0,0 +1,123 @@
+#include "Kernel.h"
+#include "MandelbrotKernel.h"
+#include "SimdKernel.h"
+#include "CpuFeatures.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+
+bool View::parse(const std::string& re, const std::string& im, double zoom, View& view) {
+	view.zoom_level = zoom * log(10.0);
+	unsigned int limbs = precisionLimbs(view.zoom_level);
+	return BigFixed::parse(re, limbs, view.pos_x) && BigFixed::parse(im, limbs, view.pos_y);
+}
+
+unsigned int View::precisionLimbs(double zoom_level) {
+	double bits = std::max(zoom_level, 0.0) / log(2.0) + log2(320.0) + 16 + 32;
+	return BigFixed::limbsForBits((unsigned int)ceil(bits));
+}
+
+BigFixed View::planeDistance(double pixels, double zoom_level) {
+	View view;
+	view.zoom_level = zoom_level;
+	FloatExp size = view.pixelSizeExp();
+	return BigFixed::fromScaled(pixels * size.m, size.e, precisionLimbs(zoom_level));
+}
+
+double View::pixelSize() const {
+	return 1.0 / 320.0 / exp(zoom_level);
+}
+
+double View::log2PixelSize() const {
+	return -zoom_level / log(2.0) - log2(320.0);
+}
+
+FloatExp View::pixelSizeExp() const {
+	double log2Size = log2PixelSize();
+	double whole = floor(log2Size);
+	return FloatExp(exp2(log2Size - whole), (int64_t)whole);
+}
+
+double View::offsetRe(unsigned int x) const {
+	return ((x + 0.5) - width * 0.5) * pixelSize();
+}
+
+double View::offsetIm(unsigned int y) const {
+	return ((y + 0.5) - height * 0.5) * pixelSize();
+}
+
+void Frame::resize(unsigned int w, unsigned int h) {
+	width = w;
+	height = h;
+	iterations.assign((size_t)w * h, 0);
+	smooth.assign((size_t)w * h, -1.0);
+	norms.assign((size_t)w * h, 0.0f);
+	pixels.assign((size_t)w * h, 0xff000000u);
+}
+
+void Frame::setInterior(size_t index, int max_iters) {
+	iterations[index] = max_iters;
+	smooth[index] = -1.0;
+	norms[index] = 0.0f;
+}
+
+void Frame::setEscaped(size_t index, int iters, double norm) {
+	iterations[index] = iters;
+	smooth[index] = iters + 1 - log2(log(sqrt(norm)));
+	norms[index] = (float)norm;
+}
+
+template <class T>
+static void shiftBuffer(std::vector<T>& buffer, unsigned int width, unsigned int height, int dx, int dy) {
+	unsigned int columns = width - (unsigned int)abs(dx);
+	unsigned int from = dx > 0 ? dx : 0, to = dx < 0 ? -dx : 0;
+	// Rows are walked away from the side they move to, so no source row is overwritten before it moves
+	for (unsigned int i = 0; i < height - (unsigned int)abs(dy); i++) {
+		unsigned int y = dy > 0 ? i : height - 1 - i;
+		T* row = buffer.data() + (size_t)y * width;
+		const T* source = buffer.data() + (size_t)(y + dy) * width;
+		std::memmove(row + to, source + from, columns * sizeof(T));
+	}
+}
+
+void Frame::shift(int dx, int dy) {
+	if ((unsigned int)abs(dx) >= width || (unsigned int)abs(dy) >= height) {
+		return;
+	}
+	shiftBuffer(iterations, width, height, dx, dy);
+	shiftBuffer(smooth, width, height, dx, dy);
+	shiftBuffer(norms, width, height, dx, dy);
+	shiftBuffer(pixels, width, height, dx, dy);
+}
+
+double periodicityTolerance(const View& view, double resolution) {
+	return std::min(std::max(view.pixelSize() * 1e-3, resolution), 1e-10);
+}
+
+double interiorLog2Threshold(const View& view) {
+	return std::min(2.0 * (view.log2PixelSize() - log2(1000.0)), log2(1e-20));
+}
+
+const char* kernelIsaName(KernelIsa isa) {
+	switch (isa) {
+	case KernelIsa::Avx2:
+		return "avx2";
+	case KernelIsa::Avx512:
+		return "avx512";
+	default:
+		return "scalar";
+	}
+}
+
+std::unique_ptr<Kernel> createKernel(KernelIsa isa) {
+	if (isa == KernelIsa::Scalar) {
+		return std::make_unique<MandelbrotKernel>();
+	}
+	return std::make_unique<SimdKernel>(isa);
+}
+
+std::unique_ptr<Kernel> createKernel() {
+	return createKernel(bestKernelIsa());
+}
@@ -0,0 +1,101 @@
+#pragma once
+
+#include "BigFixed.h"
+#include "FloatExp.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+struct View {
+	BigFixed pos_x, pos_y;
+	double zoom_level = 1.0;
+	unsigned int width = 1280, height = 720;
+	int max_iters = 2000;
+
+	// Centers view on re + im i, given as decimal strings, at a magnification of 10^zoom; width, height
+	// and max_iters are left as they are. False if re or im doesn't parse.
+	static bool parse(const std::string& re, const std::string& im, double zoom, View& view);
+
+	// Fraction limbs needed to address single pixels of a frame up to 65536 pixels wide at zoom_level
+	static unsigned int precisionLimbs(double zoom_level);
+	// Length of a distance given in pixels, exact beyond the range of double
+	static BigFixed planeDistance(double pixels, double zoom_level);
+
+	// Size of one pixel in the complex plane, matching the 320 pixels per unit of fragment.glsl
+	double pixelSize() const;
+	double log2PixelSize() const;
+	// pixelSize() without underflow past zooms of 1e308
+	FloatExp pixelSizeExp() const;
+	// Distance of a pixel center from pos_x/pos_y
+	double offsetRe(unsigned int x) const;
+	double offsetIm(unsigned int y) const;
+};
+
+// Row 0 is the bottom of the image, the same orientation as gl_FragCoord and glTexImage2D.
+// Kernels only fill the iteration buffers; pixels is colored from them afterwards (Palette.h).
+struct Frame {
+	unsigned int width = 0, height = 0;
+	std::vector<int> iterations;
+	// Continuous iteration count of escaped pixels, -1 for interior ones
+	std::vector<double> smooth;
+	// Final |z|^2 of escaped pixels, 0 for interior ones
+	std::vector<float> norms;
+	std::vector<uint32_t> pixels;
+
+	void resize(unsigned int w, unsigned int h);
+	void setInterior(size_t index, int max_iters);
+	// iters and norm are taken after the extra smoothing iteration
+	void setEscaped(size_t index, int iters, double norm);
+	bool isInterior(size_t index) const { return smooth[index] < 0.0; }
+	// Moves every buffer so pixel (x, y) takes the result of (x + dx, y + dy); pixels whose source lies
+	// outside the frame keep stale data
+	void shift(int dx, int dy);
+	// Marks a pixel whose result can't be trusted yet; iters is where the problem was detected
+	void setGlitched(size_t index, int iters) { iterations[index] = -1 - iters; }
+	bool isGlitched(size_t index) const { return iterations[index] < 0; }
+	int glitchIteration(size_t index) const { return -1 - iterations[index]; }
+	// Gives a pixel the result of another one without iterating it
+	void copyResult(size_t index, size_t from) {
+		iterations[index] = iterations[from];
+		smooth[index] = smooth[from];
+		norms[index] = norms[from];
+	}
+};
+
+// Distance under which an orbit counts as having come back to a point it saved (Brent's cycle detection).
+// It scales with the pixel size so orbits near the boundary aren't cut short, but doesn't go below
+// resolution, the smallest difference the tier's arithmetic still tells apart.
+double periodicityTolerance(const View& view, double resolution);
+
+// log2 of the squared |dz/dz1| under which an orbit counts as contracting onto an attracting cycle.
+// Exterior orbits also shrink it for a while when they pass close to 0, by an amount that grows with
+// the zoom, so the threshold follows the pixel size down.
+double interiorLog2Threshold(const View& view);
+
+enum class KernelIsa {
+	Scalar,
+	Avx2,
+	Avx512
+};
+
+const char* kernelIsaName(KernelIsa isa);
+
+class Kernel {
+public:
+	virtual ~Kernel() = default;
+
+	virtual const char* name() const = 0;
+	// Called once per frame before evaluate() runs on the worker threads
+	virtual void prepare(const View& /*view*/) {}
+	// pixels holds frame indices (y * width + x); every listed pixel gets a result.
+	// Returns the iterations actually run for them, so pixels settled by a shortcut or a periodicity
+	// check count only what they ran before it.
+	virtual uint64_t evaluate(const View& view, Frame& frame, const unsigned int* pixels, size_t count) const = 0;
+};
+
+std::unique_ptr<Kernel> createKernel(KernelIsa isa);
+// Widest kernel the running CPU supports
+std::unique_ptr<Kernel> createKernel();
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+
+// Single-slot handoff between two threads without locks. post() replaces a value the reader hasn't
+// taken yet, so a slow reader only ever sees the newest one and superseded values are dropped.
+template <class T>
+class Mailbox {
+public:
+	Mailbox() = default;
+	~Mailbox() { delete slot.exchange(nullptr); }
+
+	Mailbox(const Mailbox&) = delete;
+	Mailbox& operator=(const Mailbox&) = delete;
+
+	void post(std::unique_ptr<T> value) { delete slot.exchange(value.release()); }
+	// Null when nothing was posted since the last take()
+	std::unique_ptr<T> take() { return std::unique_ptr<T>(slot.exchange(nullptr)); }
+	bool empty() const { return slot.load() == nullptr; }
+
+private:
+	std::atomic<T*> slot{ nullptr };
+};
@@ -1,13 +1,26 @@
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
 
+#include "Bench.h"
+#include "OfflineRender.h"
+#include "RenderThread.h"
+#include "Trace.h"
+#include "Verify.h"
+
+#include <cmath>
 #include <iostream>
+#include <iomanip>
 #include <fstream>
 #include <sstream>
 
 unsigned int scr_width = 1280, scr_height = 720;
-float pos_x = 0.0f, pos_y = 0.0f;
-float zoom_level = 1.0f;
+BigFixed pos_x, pos_y;
+double zoom_level = 1.0;
+// Set by the callbacks; the main loop then posts a new request to the render thread
+bool view_changed = true, colors_changed = false;
+Palette::Scheme scheme = Palette::Scheme::Rainbow;
+Palette::Mode color_mode = Palette::Mode::Smooth;
+double palette_offset = 0.0;
 
 std::string readFile(std::string filePath) {
 	std::ifstream ifs;
@@ -24,10 +37,36 @@ void sizeCallback(GLFWwindow* window, int width, int height) {
 	glViewport(0, 0, width, height);
 	scr_width = width;
 	scr_height = height;
+	view_changed = true;
 }
 
 void scrollCallback(GLFWwindow* window, double xoffset, double yoffset) {
 	zoom_level += ((yoffset > 0) ? 1 : -1) * 0.1f;
+	view_changed = true;
+}
+
+// P switches the palette, M the coloring mode, [ and ] shift the palette
+void keyCallback(GLFWwindow* /*window*/, int key, int /*scancode*/, int action, int /*mods*/) {
+	if (action == GLFW_RELEASE) {
+		return;
+	}
+	switch (key) {
+	case GLFW_KEY_P:
+		scheme = scheme == Palette::Scheme::Rainbow ? Palette::Scheme::Grayscale : Palette::Scheme::Rainbow;
+		break;
+	case GLFW_KEY_M:
+		color_mode = color_mode == Palette::Mode::Smooth ? Palette::Mode::Bands : Palette::Mode::Smooth;
+		break;
+	case GLFW_KEY_LEFT_BRACKET:
+		palette_offset -= 1.0 / 32.0;
+		break;
+	case GLFW_KEY_RIGHT_BRACKET:
+		palette_offset += 1.0 / 32.0;
+		break;
+	default:
+		return;
+	}
+	colors_changed = true;
 }
 
 bool dragging = false;
@@ -41,18 +80,50 @@ void mouseButtonCallback(GLFWwindow* window, int button, int action, int mods) {
 	}
 }
 
+// Drags move the view by whole pixels so the renderer can shift the last frame; the fractions wait here
+double pan_x = 0.0, pan_y = 0.0;
 void cursorPosCallback(GLFWwindow* window, double x, double y) {
-	float x_change = 0.0f, y_change = 0.0f;
 	if (dragging) {
-		x_change += cstart_x - x;
-		y_change += cstart_y - y;
+		pan_x += cstart_x - x;
+		pan_y += cstart_y - y;
+	}
+	double x_change = round(pan_x), y_change = round(pan_y);
+	pan_x -= x_change;
+	pan_y -= y_change;
+	if (x_change != 0.0 || y_change != 0.0) {
+		pos_x += View::planeDistance(x_change, zoom_level);
+		pos_y -= View::planeDistance(y_change, zoom_level);
+		view_changed = true;
 	}
-	pos_x += x_change / 320.0f / exp(zoom_level);
-	pos_y -= y_change / 320.0f / exp(zoom_level);
 	glfwGetCursorPos(window, &cstart_x, &cstart_y);
 }
 
-int main() {
+// --stats <file> streams FrameStats summaries to file once a second, CSV or JSON by its extension.
+// --trace <file> records what every thread did until exit for chrome://tracing or Perfetto.
+int main(int argc, char** argv) {
+	if (argc > 1 && std::string(argv[1]) == "bench") {
+		return runBench(argc - 2, argv + 2);
+	}
+	if (argc > 1 && std::string(argv[1]) == "verify") {
+		return runVerify(argc - 2, argv + 2);
+	}
+	if (argc > 1 && std::string(argv[1]) == "render") {
+		return runRender(argc - 2, argv + 2);
+	}
+
+	StatsStream stats_stream;
+	for (int i = 1; i < argc; i++) {
+		if (std::string(argv[i]) == "--stats" && i + 1 < argc) {
+			if (!stats_stream.open(argv[++i])) {
+				std::cout << "Failed to open " << argv[i] << std::endl;
+				return -1;
+			}
+		} else if (std::string(argv[i]) == "--trace" && i + 1 < argc) {
+			startTrace(argv[++i]);
+			setTraceThreadName("main");
+		}
+	}
+
 	glfwInit();
 	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
 	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 6);
@@ -69,6 +140,7 @@ int main() {
 	glfwSetScrollCallback(window, scrollCallback);
 	glfwSetMouseButtonCallback(window, mouseButtonCallback);
 	glfwSetCursorPosCallback(window, cursorPosCallback);
+	glfwSetKeyCallback(window, keyCallback);
 
 	if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress)) {
 		std::cout << "Failed to initialize GLAD";
@@ -142,43 +214,106 @@ int main() {
 	glBindBuffer(GL_ARRAY_BUFFER, 0);
 	glBindVertexArray(0);
 
-	int timeLoc = glGetUniformLocation(shaderProgram, "time");
-	int zoomLevelLoc = glGetUniformLocation(shaderProgram, "zoomLevel");
+	unsigned int texture;
+	glGenTextures(1, &texture);
+	glBindTexture(GL_TEXTURE_2D, texture);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	unsigned int texture_width = 0, texture_height = 0;
+
+	int frameLoc = glGetUniformLocation(shaderProgram, "frame");
 	int windowSizeLoc = glGetUniformLocation(shaderProgram, "windowSize");
-	int posLoc = glGetUniformLocation(shaderProgram, "pos");
 
-	float pt = glfwGetTime();
-	float timePassed = 0.0f;
-	int frames = 0;
+	TileScheduler scheduler;
+	Renderer renderer(scheduler);
+	renderer.setAdaptiveIterations(true);
+	FrameStats stats;
+	RenderThread render_thread(renderer, &stats);
+	int max_iters = 0;
+	double cap_fraction = 0.0;
+
+	double pt = glfwGetTime();
+	double timePassed = 0.0;
 
 	while (!glfwWindowShouldClose(window)) {
 		glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
 		glClear(GL_COLOR_BUFFER_BIT);
 
-		float time = glfwGetTime();
+		double time = glfwGetTime();
+
+		if (view_changed || colors_changed) {
+			RenderThread::Request request;
+			request.view.pos_x = pos_x;
+			request.view.pos_y = pos_y;
+			request.view.zoom_level = zoom_level;
+			request.view.width = scr_width;
+			request.view.height = scr_height;
+			request.scheme = scheme;
+			request.mode = color_mode;
+			request.palette_offset = palette_offset;
+			render_thread.submit(request);
+			view_changed = false;
+			colors_changed = false;
+		}
+
+		glActiveTexture(GL_TEXTURE0);
+		glBindTexture(GL_TEXTURE_2D, texture);
+		if (std::unique_ptr<RenderThread::Image> image = render_thread.latest()) {
+			TraceScope scope("upload");
+			double upload_start = glfwGetTime();
+			if (texture_width != image->width || texture_height != image->height) {
+				glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, image->width, image->height, 0, GL_RGBA, GL_UNSIGNED_BYTE, image->pixels.data());
+				texture_width = image->width;
+				texture_height = image->height;
+			} else {
+				glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, image->width, image->height, GL_RGBA, GL_UNSIGNED_BYTE, image->pixels.data());
+			}
+			stats.record(FrameStats::Stage::Upload, glfwGetTime() - upload_start);
+			max_iters = image->max_iters;
+			cap_fraction = image->cap_fraction;
+		}
+
 		glUseProgram(shaderProgram);
-		glUniform1f(timeLoc, time);
-		glUniform1f(zoomLevelLoc, zoom_level);
+		glUniform1i(frameLoc, 0);
 		glUniform2f(windowSizeLoc, scr_width, scr_height);
-		glUniform2f(posLoc, pos_x, pos_y);
 
 		glBindVertexArray(vao);
 		glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
 		glBindVertexArray(0);
 
-		glfwSwapBuffers(window);
+		double present_start = glfwGetTime();
+		{
+			TraceScope scope("swap buffers");
+			glfwSwapBuffers(window);
+		}
+		stats.record(FrameStats::Stage::Present, glfwGetTime() - present_start);
 		glfwPollEvents();
 
+		if (time > pt) {
+			stats.record(FrameStats::Stage::Frame, time - pt);
+		}
 		timePassed += (time - pt);
-		if (timePassed >= 1.0f) {
-			glfwSetWindowTitle(window, (std::string("Fractal Viewer | ") + std::to_string(frames)).c_str());
-			timePassed = 0.0f;
-			frames = 0;
+		if (timePassed >= 1.0) {
+			FrameStats::Summary summary = stats.takeWindow(time);
+			stats_stream.write(summary, "window");
+			const auto& frame = summary.stages[(int)FrameStats::Stage::Frame];
+			std::stringstream title;
+			title << "Fractal Viewer | " << std::fixed << std::setprecision(1) << frame.p50 * 1e3 << " ms p50, "
+				<< frame.p99 * 1e3 << " ms p99 | " << std::setprecision(0) << summary.iteration_rate * 1e-6 << " Miter/s | "
+				<< max_iters << " iterations, " << std::setprecision(1) << cap_fraction * 100.0 << "% capped";
+			glfwSetWindowTitle(window, title.str().c_str());
+			timePassed = 0.0;
 		}
-		frames++;
 		pt = time;
 	}
 
+	stats_stream.write(stats.session(glfwGetTime()), "session");
+	if (!stopTrace()) {
+		std::cout << "Failed to write trace" << std::endl;
+	}
+	glDeleteTextures(1, &texture);
 	glfwTerminate();
 	return 0;
 }
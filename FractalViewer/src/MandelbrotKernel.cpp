@@ -0,0 +1,88 @@
+#include "MandelbrotKernel.h"
+
+#include <cmath>
+
+bool MandelbrotKernel::inMainComponents(double cre, double cim) {
+	double q = (cre - 0.25) * (cre - 0.25) + cim * cim;
+	bool cardoidCheck = (q * (q + (cre - 0.25)) <= (cim * cim) / 4.0);
+	bool circleCheck = (((cre + 1.0) * (cre + 1.0) + cim * cim) <= 0.0625);
+	return cardoidCheck || circleCheck;
+}
+
+uint64_t MandelbrotKernel::evaluate(const View& view, Frame& frame, const unsigned int* pixels, size_t count) const {
+	double center_re = view.pos_x.toDouble();
+	double center_im = view.pos_y.toDouble();
+	double tolerance = periodicityTolerance(view, periodicity_resolution);
+	double threshold = exp2(interiorLog2Threshold(view));
+	uint64_t iterations = 0;
+	for (size_t i = 0; i < count; i++) {
+		unsigned int pixel = pixels[i];
+		double cre = view.offsetRe(pixel % frame.width) + center_re;
+		double cim = view.offsetIm(pixel / frame.width) + center_im;
+		iterations += evaluatePoint(view, frame, pixel, cre, cim, tolerance * tolerance, threshold);
+	}
+	return iterations;
+}
+
+int MandelbrotKernel::evaluatePoint(const View& view, Frame& frame, size_t index, double cre, double cim, double period_tolerance2, double derivative_threshold) {
+	if (inMainComponents(cre, cim)) {
+		frame.setInterior(index, view.max_iters);
+		return 0;
+	}
+
+	int iters = 0;
+	double re = 0.0;
+	double im = 0.0;
+	double re2 = 0.0;
+	double im2 = 0.0;
+	// Brent: compare z with one saved at the last power of two; an orbit that comes back has fallen
+	// into an attracting cycle and the point is interior
+	double save_re = 0.0;
+	double save_im = 0.0;
+	int next_save = periodicity_interval;
+	// |dz/dz1|^2 grows by 4|z|^2 every iteration and sinks towards 0 once the orbit is attracted
+	double derivative = 1.0;
+	while (re2 + im2 <= 4 && iters < view.max_iters) {
+		im = 2 * re * im + cim;
+		re = re2 - im2 + cre;
+		re2 = re * re;
+		im2 = im * im;
+		iters++;
+		derivative *= 4 * (re2 + im2);
+
+		if (iters % periodicity_interval == 0) {
+			double dr = re - save_re, di = im - save_im;
+			if ((dr * dr + di * di < period_tolerance2 || derivative < derivative_threshold) && re2 + im2 <= 4) {
+				frame.setInterior(index, view.max_iters);
+				return iters;
+			}
+			if (iters >= next_save) {
+				save_re = re;
+				save_im = im;
+				next_save *= 2;
+			}
+		}
+	}
+
+	if (iters == view.max_iters) {
+		frame.setInterior(index, view.max_iters);
+		return iters;
+	}
+
+	im = 2 * re * im + cim;
+	re = re2 - im2 + cre;
+	re2 = re * re;
+	im2 = im * im;
+	iters++;
+	frame.setEscaped(index, iters, re2 + im2);
+	return iters;
+}
+
+void MandelbrotKernel::render(const View& view, Frame& frame) const {
+	frame.resize(view.width, view.height);
+	std::vector<unsigned int> pixels(frame.iterations.size());
+	for (size_t i = 0; i < pixels.size(); i++) {
+		pixels[i] = (unsigned int)i;
+	}
+	evaluate(view, frame, pixels.data(), pixels.size());
+}
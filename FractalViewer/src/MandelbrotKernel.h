@@ -0,0 +1,25 @@
+#pragma once
+
+#include "Kernel.h"
+
+// CPU port of the escape-time loop in resources/fragment.glsl.
+class MandelbrotKernel : public Kernel {
+public:
+	// Smallest orbit distance double tells apart for |z| around 1
+	static constexpr double periodicity_resolution = 1e-15;
+	// Cycle and derivative checks run every this many iterations; any multiple of the period is found
+	// just as well and the escape loop stays cheap
+	static constexpr int periodicity_interval = 8;
+
+	static bool inMainComponents(double cre, double cim);
+
+	// period_tolerance2 is the squared periodicityTolerance() of the view, derivative_threshold the
+	// interiorLog2Threshold() raised to a power of two. Returns the iterations it ran.
+	static int evaluatePoint(const View& view, Frame& frame, size_t index, double cre, double cim, double period_tolerance2, double derivative_threshold);
+
+	const char* name() const override { return "scalar"; }
+	uint64_t evaluate(const View& view, Frame& frame, const unsigned int* pixels, size_t count) const override;
+
+	// Renders the whole view on the calling thread
+	void render(const View& view, Frame& frame) const;
+};
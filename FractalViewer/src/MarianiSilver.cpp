@@ -0,0 +1,98 @@
+#include "MarianiSilver.h"
+
+namespace {
+
+// Rectangles are inclusive, [x0, x1] x [y0, y1], and their border is already evaluated
+struct Subdivision {
+	const Kernel& kernel;
+	const View& view;
+	Frame& frame;
+	std::vector<unsigned int>& pixels;
+
+	void evaluate() {
+		kernel.evaluate(view, frame, pixels.data(), pixels.size());
+	}
+
+	// Number of border pixels that reached max_iters
+	size_t interiorBorder(unsigned int x0, unsigned int y0, unsigned int x1, unsigned int y1) const {
+		size_t count = 0;
+		for (unsigned int x = x0; x <= x1; x++) {
+			count += frame.iterations[y0 * view.width + x] == view.max_iters;
+			count += frame.iterations[y1 * view.width + x] == view.max_iters;
+		}
+		for (unsigned int y = y0 + 1; y < y1; y++) {
+			count += frame.iterations[y * view.width + x0] == view.max_iters;
+			count += frame.iterations[y * view.width + x1] == view.max_iters;
+		}
+		return count;
+	}
+
+	void split(unsigned int x0, unsigned int y0, unsigned int x1, unsigned int y1) {
+		if (x1 - x0 < 2 || y1 - y0 < 2) {
+			return;
+		}
+
+		size_t border = 2 * (size_t)(x1 - x0) + 2 * (size_t)(y1 - y0);
+		size_t interior = interiorBorder(x0, y0, x1, y1);
+		if (interior == border) {
+			for (unsigned int y = y0 + 1; y < y1; y++) {
+				for (unsigned int x = x0 + 1; x < x1; x++) {
+					frame.setInterior(y * view.width + x, view.max_iters);
+				}
+			}
+			return;
+		}
+
+		pixels.clear();
+		// With no interior on the border there is rarely anything to fill further down, and the short
+		// lists of the split lines would leave SIMD lanes idle
+		if (interior == 0 || x1 - x0 <= mariani_silver_min_size || y1 - y0 <= mariani_silver_min_size) {
+			for (unsigned int y = y0 + 1; y < y1; y++) {
+				for (unsigned int x = x0 + 1; x < x1; x++) {
+					pixels.push_back(y * view.width + x);
+				}
+			}
+			evaluate();
+			return;
+		}
+
+		unsigned int xm = (x0 + x1) / 2, ym = (y0 + y1) / 2;
+		for (unsigned int x = x0 + 1; x < x1; x++) {
+			pixels.push_back(ym * view.width + x);
+		}
+		for (unsigned int y = y0 + 1; y < y1; y++) {
+			if (y != ym) {
+				pixels.push_back(y * view.width + xm);
+			}
+		}
+		evaluate();
+
+		split(x0, y0, xm, ym);
+		split(xm, y0, x1, ym);
+		split(x0, ym, xm, y1);
+		split(xm, ym, x1, y1);
+	}
+};
+
+}
+
+void subdivideTile(const Kernel& kernel, const View& view, Frame& frame, const Tile& tile, std::vector<unsigned int>& pixels) {
+	Subdivision subdivision{ kernel, view, frame, pixels };
+	unsigned int x1 = tile.x1 - 1, y1 = tile.y1 - 1;
+
+	pixels.clear();
+	for (unsigned int x = tile.x0; x <= x1; x++) {
+		pixels.push_back(tile.y0 * view.width + x);
+		if (y1 != tile.y0) {
+			pixels.push_back(y1 * view.width + x);
+		}
+	}
+	for (unsigned int y = tile.y0 + 1; y < y1; y++) {
+		pixels.push_back(y * view.width + tile.x0);
+		if (x1 != tile.x0) {
+			pixels.push_back(y * view.width + x1);
+		}
+	}
+	subdivision.evaluate();
+	subdivision.split(tile.x0, tile.y0, x1, y1);
+}
@@ -0,0 +1,16 @@
+#pragma once
+
+#include "Kernel.h"
+#include "TileScheduler.h"
+
+#include <vector>
+
+// Rectangles at most this many pixels across are iterated as a whole instead of split further
+constexpr unsigned int mariani_silver_min_size = 6;
+
+// Mariani-Silver subdivision: only the border of a rectangle is iterated. When every border pixel is
+// interior the whole rectangle is, because the set has no holes, and it is filled without iterating;
+// otherwise the rectangle is split in four along its middle lines and each part is checked again.
+// Escaped borders are always split, since filling them would flatten the smooth coloring.
+// pixels is scratch space for the lists handed to the kernel.
+void subdivideTile(const Kernel& kernel, const View& view, Frame& frame, const Tile& tile, std::vector<unsigned int>& pixels);
@@ -0,0 +1,148 @@
+#include "OfflineRender.h"
+#include "Png.h"
+#include "Renderer.h"
+
+#include <cerrno>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+namespace {
+
+// Rerenders of an unchanged view before an unsettled iteration budget is taken as it is
+constexpr int max_budget_rounds = 16;
+// View::precisionLimbs() covers frames up to 65536 pixels wide
+constexpr long max_side = 65536;
+// A Frame takes 20 bytes per pixel and the renderer keeps a second one to preview from, so this
+// stays near 2.5 GiB
+constexpr long long max_pixels = 1ll << 26;
+
+// log10 of the magnification; "1e300" and "2.5E-3" are split so magnifications beyond the range of
+// double still parse
+bool parseZoom(const std::string& text, double& zoom) {
+	size_t e = text.find_first_of("eE");
+	char* end = nullptr;
+	double mantissa = strtod(text.substr(0, e).c_str(), &end);
+	if (*end != '\0' || !(mantissa > 0.0)) {
+		return false;
+	}
+	double exponent = 0.0;
+	if (e != std::string::npos) {
+		exponent = strtod(text.c_str() + e + 1, &end);
+		if (*end != '\0') {
+			return false;
+		}
+	}
+	zoom = log10(mantissa) + exponent;
+	return true;
+}
+
+// A whole number of at least 1 with nothing after it
+bool parseCount(const std::string& text, long& count) {
+	char* end = nullptr;
+	errno = 0;
+	count = strtol(text.c_str(), &end, 10);
+	return !text.empty() && *end == '\0' && errno != ERANGE && count >= 1;
+}
+
+// Only the syntax; runRender() checks the limits so it can say which one was exceeded
+bool parseSize(const std::string& text, long& width, long& height) {
+	size_t x = text.find('x');
+	return x != std::string::npos && parseCount(text.substr(0, x), width) && parseCount(text.substr(x + 1), height);
+}
+
+int usage() {
+	std::cout << "Usage: FractalViewer render --center RE,IM --zoom Z [--size WxH] [--iters N] "
+		"[--palette rainbow|grayscale] -o FILE.png" << std::endl;
+	return 1;
+}
+
+}
+
+int runRender(int argc, char** argv) {
+	View view;
+	// log10 of the magnification, View's own unless --zoom is given
+	double zoom = view.zoom_level / log(10.0);
+	std::string center = "-0.5,0", output;
+	bool fixed_iters = false;
+	Palette::Scheme scheme = Palette::Scheme::Rainbow;
+	for (int i = 0; i < argc; i++) {
+		std::string arg = argv[i];
+		if (i + 1 >= argc) {
+			return usage();
+		}
+		std::string value = argv[++i];
+		if (arg == "--center") {
+			center = value;
+		} else if (arg == "--zoom") {
+			if (!parseZoom(value, zoom)) {
+				return usage();
+			}
+		} else if (arg == "--size") {
+			long width, height;
+			if (!parseSize(value, width, height)) {
+				return usage();
+			}
+			if (width > max_side || height > max_side || (long long)width * height > max_pixels) {
+				std::cout << "--size " << value << " is too large: at most " << max_side << " pixels a side and "
+					<< max_pixels << " in all" << std::endl;
+				return 1;
+			}
+			view.width = (unsigned int)width;
+			view.height = (unsigned int)height;
+		} else if (arg == "--iters") {
+			long iters;
+			if (!parseCount(value, iters)) {
+				return usage();
+			}
+			if (iters > IterationBudget::max_iters) {
+				std::cout << "--iters " << value << " is too large: at most " << IterationBudget::max_iters << std::endl;
+				return 1;
+			}
+			view.max_iters = (int)iters;
+			fixed_iters = true;
+		} else if (arg == "--palette") {
+			if (value == "grayscale") {
+				scheme = Palette::Scheme::Grayscale;
+			} else if (value != "rainbow") {
+				return usage();
+			}
+		} else if (arg == "-o") {
+			output = value;
+		} else {
+			return usage();
+		}
+	}
+
+	size_t comma = center.find(',');
+	if (output.empty() || comma == std::string::npos ||
+		!View::parse(center.substr(0, comma), center.substr(comma + 1), zoom, view)) {
+		return usage();
+	}
+
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	TileScheduler scheduler;
+	Renderer renderer(scheduler);
+	renderer.palette().setScheme(scheme);
+	renderer.setAdaptiveIterations(!fixed_iters);
+	Frame frame;
+	renderer.render(view, frame);
+	// The viewer renders an unchanged view again until its budget settles; do the same before writing
+	for (int round = 0; !fixed_iters && !renderer.iterationBudget().settled() && round < max_budget_rounds; round++) {
+		renderer.preview(view, frame);
+		while (renderer.refine(frame, 1.0)) {
+		}
+	}
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	if (!writePng(output, frame)) {
+		std::cout << "Failed to write " << output << std::endl;
+		return 1;
+	}
+	int iters = fixed_iters ? view.max_iters : renderer.iterationBudget().current();
+	std::cout << "Wrote " << output << ": " << view.width << "x" << view.height << ", " << iters << " iterations, "
+		<< seconds << " s" << std::endl;
+	return 0;
+}
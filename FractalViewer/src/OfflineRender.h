@@ -0,0 +1,7 @@
+#pragma once
+
+// `FractalViewer render --center RE,IM --zoom Z --size WxH [--iters N] [--palette NAME] -o FILE.png`
+// renders one view with the viewer's engine and writes it as a PNG, without creating a window.
+// Z is the magnification and may be written as 1e300 or beyond. Without --iters the iteration
+// budget is chosen as in the viewer.
+int runRender(int argc, char** argv);
@@ -0,0 +1,52 @@
+#include "Palette.h"
+
+#include <algorithm>
+#include <cmath>
+
+static float fract(float x) {
+	return x - floorf(x);
+}
+
+static uint32_t toUnorm8(float c) {
+	return (uint32_t)(std::min(std::max(c, 0.0f), 1.0f) * 255.0f + 0.5f);
+}
+
+uint32_t hsv2rgb(float h, float s, float v) {
+	const float K[4] = { 1.0f, 2.0f / 3.0f, 1.0f / 3.0f, 3.0f };
+	uint32_t rgba = 0xff000000u;
+	for (int i = 0; i < 3; i++) {
+		float p = fabsf(fract(h + K[i]) * 6.0f - K[3]);
+		float c = v * (K[0] + (std::min(std::max(p - K[0], 0.0f), 1.0f) - K[0]) * s);
+		rgba |= toUnorm8(c) << (8 * i);
+	}
+	return rgba;
+}
+
+Palette::Palette() {
+	rebuild();
+}
+
+void Palette::setScheme(Scheme value) {
+	scheme = value;
+	rebuild();
+}
+
+void Palette::rebuild() {
+	table.resize(table_size);
+	for (int i = 0; i < table_size; i++) {
+		float t = (float)i / table_size;
+		if (scheme == Scheme::Grayscale) {
+			// Dark to light and back, so the cycle has no seam
+			uint32_t c = toUnorm8(0.5f - 0.5f * cosf(t * 6.2831853f));
+			table[i] = 0xff000000u | c << 16 | c << 8 | c;
+		} else {
+			table[i] = hsv2rgb(t, 1.0f, 1.0f);
+		}
+	}
+}
+
+void Palette::apply(Frame& frame, size_t begin, size_t end) const {
+	for (size_t i = begin; i < end; i++) {
+		frame.pixels[i] = color(frame, i);
+	}
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include "Kernel.h"
+
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+uint32_t hsv2rgb(float h, float s, float v);
+
+// Turns the iteration data of a frame into colors. Coloring is a separate pass over Frame::smooth and
+// Frame::iterations, so a new palette, offset or mode only costs a table lookup per pixel.
+class Palette {
+public:
+	enum class Scheme {
+		Rainbow,
+		Grayscale
+	};
+
+	enum class Mode {
+		// Continuous iteration count, no visible bands
+		Smooth,
+		// Whole iteration counts, one flat color per band
+		Bands
+	};
+
+	// Entries of the color table for one cycle of the palette, a power of two
+	static constexpr int table_size = 4096;
+
+	Palette();
+
+	void setScheme(Scheme value);
+	void setMode(Mode value) { mode = value; }
+	// Shifts the palette by a fraction of a cycle
+	void setOffset(double value) { offset = value; updateMapping(); }
+	// Iterations per cycle of the palette
+	void setPeriod(double value) { period = value; updateMapping(); }
+
+	Scheme currentScheme() const { return scheme; }
+	Mode currentMode() const { return mode; }
+	double currentOffset() const { return offset; }
+	double currentPeriod() const { return period; }
+
+	// Color of one pixel; apply() colors whole ranges the same way
+	uint32_t color(const Frame& frame, size_t index) const {
+		if (frame.isInterior(index)) {
+			return 0xff000000u;
+		}
+		double value = mode == Mode::Smooth ? frame.smooth[index] : (double)frame.iterations[index];
+		// table_size is a power of two, so masking wraps the entry into the cycle, negative ones included
+		int64_t entry = (int64_t)floor(value * scale + shift);
+		return table[entry & (table_size - 1)];
+	}
+	// Colors pixels [begin, end) of frame from its iteration data
+	void apply(Frame& frame, size_t begin, size_t end) const;
+	void apply(Frame& frame) const { apply(frame, 0, frame.pixels.size()); }
+
+private:
+	void rebuild();
+	void updateMapping() {
+		scale = table_size / period;
+		shift = offset * table_size;
+	}
+
+	Scheme scheme = Scheme::Rainbow;
+	Mode mode = Mode::Smooth;
+	double offset = 0.0;
+	double period = 256.0;
+	// Table entries per iteration and the entry iteration 0 maps to, from period and offset
+	double scale = table_size / 256.0;
+	double shift = 0.0;
+	std::vector<uint32_t> table;
+};
@@ -0,0 +1,250 @@
+#include "PerturbationKernel.h"
+#include "MandelbrotKernel.h"
+#include "Trace.h"
+
+#include <algorithm>
+#include <cmath>
+
+void PerturbationKernel::prepare(const View& view) {
+	{
+		TraceScope scope("reference orbit");
+		orbit.compute(view.pos_x, view.pos_y, view.max_iters, View::precisionLimbs(view.zoom_level));
+	}
+	ref_x = 0.0;
+	ref_y = 0.0;
+	buildApproximations(view);
+}
+
+void PerturbationKernel::rebase(const View& view, unsigned int pixel) {
+	ref_x = (pixel % view.width + 0.5) - view.width * 0.5;
+	ref_y = (pixel / view.width + 0.5) - view.height * 0.5;
+	{
+		TraceScope scope("reference orbit");
+		orbit.compute(view.pos_x + View::planeDistance(ref_x, view.zoom_level), view.pos_y + View::planeDistance(ref_y, view.zoom_level),
+			view.max_iters, View::precisionLimbs(view.zoom_level));
+	}
+	buildApproximations(view);
+}
+
+template <class T>
+static void buildFor(const ReferenceOrbit& orbit, const View& view, const T& pixel_size, double ref_x, double ref_y,
+	bool use_series, bool use_bla, SeriesApproximation<T>& series, BlaTable<T>& table) {
+	int limit = std::min(orbit.last(), view.max_iters);
+
+	if (use_series) {
+		std::vector<typename SeriesApproximation<T>::Complex> probes;
+		for (int sy = -1; sy <= 1; sy++) {
+			for (int sx = -1; sx <= 1; sx++) {
+				if (sx != 0 || sy != 0) {
+					probes.push_back({ T(sx * 0.5 * view.width - ref_x) * pixel_size, T(sy * 0.5 * view.height - ref_y) * pixel_size });
+				}
+			}
+		}
+		series.compute(orbit, probes, limit);
+	} else {
+		series.clear();
+	}
+
+	if (use_bla) {
+		double pixels = 0.5 * hypot((double)view.width, (double)view.height) + hypot(ref_x, ref_y);
+		table.build(orbit, T(pixels) * pixel_size);
+	} else {
+		table.clear();
+	}
+}
+
+void PerturbationKernel::buildApproximations(const View& view) {
+	TraceScope scope("approximations");
+	extended = view.log2PixelSize() < extended_log2_pixel_size;
+	if (extended) {
+		buildFor<FloatExp>(orbit, view, view.pixelSizeExp(), ref_x, ref_y, use_series, use_bla, series_exp, table_exp);
+		series.clear();
+	} else {
+		buildFor<double>(orbit, view, view.pixelSize(), ref_x, ref_y, use_series, false, series, table);
+		series_exp.clear();
+		table_exp.clear();
+	}
+	// Deltas that left the FloatExp phase continue through the double table
+	if (use_bla) {
+		double pixels = 0.5 * hypot((double)view.width, (double)view.height) + hypot(ref_x, ref_y);
+		table.build(orbit, pixels * view.pixelSize());
+	} else {
+		table.clear();
+	}
+}
+
+int PerturbationKernel::iterateExtended(const View& view, double px, double py, double& dzr, double& dzi, int& steps) const {
+	const FloatExp size = view.pixelSizeExp();
+	const FloatExp dcr = FloatExp(px) * size, dci = FloatExp(py) * size;
+	const FloatExp handover(1.0, (int64_t)extended_log2_norm);
+	const FloatExp two(2.0);
+	int limit = std::min(orbit.last(), view.max_iters);
+
+	int iters = 0;
+	FloatExp dr, di;
+	int skip = series_exp.skip();
+	if (skip > 0) {
+		SeriesApproximation<FloatExp>::Complex d = series_exp.delta({ dcr, dci });
+		iters = skip;
+		dr = d.re;
+		di = d.im;
+	}
+
+	while (iters < limit) {
+		FloatExp dnorm = dr * dr + di * di;
+		if (dnorm > handover) {
+			break;
+		}
+		const BlaTable<FloatExp>::Bla* bla = dnorm < table_exp.reach() ? table_exp.lookup(iters, dnorm, limit) : nullptr;
+		if (bla) {
+			FloatExp ndr = bla->ar * dr - bla->ai * di + bla->br * dcr - bla->bi * dci;
+			FloatExp ndi = bla->ar * di + bla->ai * dr + bla->br * dci + bla->bi * dcr;
+			dr = ndr;
+			di = ndi;
+			iters += bla->steps;
+		} else {
+			FloatExp Zr(orbit.re[iters]), Zi(orbit.im[iters]);
+			FloatExp ndr = two * (Zr * dr - Zi * di) + (dr * dr - di * di) + dcr;
+			FloatExp ndi = two * (Zr * di + Zi * dr) + two * dr * di + dci;
+			dr = ndr;
+			di = ndi;
+			iters++;
+		}
+		steps++;
+	}
+
+	dzr = dr.toDouble();
+	dzi = di.toDouble();
+	return iters;
+}
+
+uint64_t PerturbationKernel::evaluate(const View& view, Frame& frame, const unsigned int* pixels, size_t count) const {
+	double center_re = view.pos_x.toDouble();
+	double center_im = view.pos_y.toDouble();
+	double size = view.pixelSize();
+	const double* Zre = orbit.re.data();
+	const double* Zim = orbit.im.data();
+	int last = orbit.last();
+	int limit = std::min(last, view.max_iters);
+	double derivative_log2_threshold = interiorLog2Threshold(view);
+	uint64_t iterations = 0;
+
+	for (size_t i = 0; i < count; i++) {
+		unsigned int pixel = pixels[i];
+		double x = (pixel % frame.width + 0.5) - view.width * 0.5;
+		double y = (pixel / frame.width + 0.5) - view.height * 0.5;
+		double cre = center_re + x * size;
+		double cim = center_im + y * size;
+		if (MandelbrotKernel::inMainComponents(cre, cim)) {
+			frame.setInterior(pixel, view.max_iters);
+			continue;
+		}
+
+		int iters = 0;
+		int steps = 0;
+		double dzr = 0.0, dzi = 0.0;
+		double dcr = (x - ref_x) * size;
+		double dci = (y - ref_y) * size;
+
+		if (extended) {
+			iters = iterateExtended(view, x - ref_x, y - ref_y, dzr, dzi, steps);
+		} else if (series.skip() > 0) {
+			int skip = series.skip();
+			SeriesApproximation<double>::Complex d = series.delta({ dcr, dci });
+			double sr = Zre[skip] + d.re, si = Zim[skip] + d.im;
+			// A pixel that is already outside escaped before the skip and has to run from the start
+			if (sr * sr + si * si <= 4) {
+				iters = skip;
+				dzr = d.re;
+				dzi = d.im;
+			}
+		}
+		// z_1 = c for every pixel; taking that step here keeps the zero factor of z_0 out of the derivative
+		if (iters == 0 && last > 0) {
+			dzr = dcr;
+			dzi = dci;
+			iters = 1;
+			steps++;
+		}
+
+		double zr = Zre[iters] + dzr;
+		double zi = Zim[iters] + dzi;
+		double norm = zr * zr + zi * zi;
+		bool glitched = false;
+		// |dz/dz_k|^2 from the iteration k the pixel starts at, as mantissa and binary exponent because an
+		// attracted orbit takes it far below the range of double at depth; it decays whatever k is
+		double derivative = 1.0;
+		int64_t derivative_exp = 0;
+		int trips = 0;
+		while (norm <= 4 && iters < view.max_iters && iters < last) {
+			double dnorm = dzr * dzr + dzi * dzi;
+			const BlaTable<double>::Bla* bla = dnorm < table.reach() ? table.lookup(iters, dnorm, limit) : nullptr;
+			if (bla) {
+				double ndr = bla->ar * dzr - bla->ai * dzi + bla->br * dcr - bla->bi * dci;
+				double ndi = bla->ar * dzi + bla->ai * dzr + bla->br * dci + bla->bi * dcr;
+				dzr = ndr;
+				dzi = ndi;
+				iters += bla->steps;
+				// A skipped run scales the derivative by |A|^2
+				derivative *= bla->ar * bla->ar + bla->ai * bla->ai;
+			} else {
+				double Zr = Zre[iters], Zi = Zim[iters];
+				double ndr = 2 * (Zr * dzr - Zi * dzi) + (dzr * dzr - dzi * dzi) + dcr;
+				double ndi = 2 * (Zr * dzi + Zi * dzr) + 2 * dzr * dzi + dci;
+				derivative *= 4 * norm;
+				dzr = ndr;
+				dzi = ndi;
+				iters++;
+			}
+			zr = Zre[iters] + dzr;
+			zi = Zim[iters] + dzi;
+			norm = zr * zr + zi * zi;
+			if (detect_glitches && norm < glitch_tolerance * (Zre[iters] * Zre[iters] + Zim[iters] * Zim[iters])) {
+				glitched = true;
+				break;
+			}
+
+			if (++trips % MandelbrotKernel::periodicity_interval == 0) {
+				FloatExp scaled(derivative, derivative_exp);
+				derivative = scaled.m;
+				derivative_exp = scaled.e;
+				if (derivative_exp < derivative_log2_threshold && norm <= 4) {
+					iters = view.max_iters;
+					break;
+				}
+			}
+		}
+
+		steps += trips;
+
+		// An escaped reference can't carry the pixel further either
+		if (glitched || (detect_glitches && norm <= 4 && iters < view.max_iters)) {
+			frame.setGlitched(pixel, iters);
+			iterations += steps;
+			continue;
+		}
+
+		// Best effort for pixels that stayed glitched: finish them on their own in plain double
+		while (norm <= 4 && iters < view.max_iters) {
+			double t = zr * zr - zi * zi + cre;
+			zi = 2 * zr * zi + cim;
+			zr = t;
+			norm = zr * zr + zi * zi;
+			iters++;
+			steps++;
+		}
+
+		// A series skip prepared for a longer budget can start past max_iters
+		if (iters >= view.max_iters) {
+			frame.setInterior(pixel, view.max_iters);
+			iterations += steps;
+			continue;
+		}
+
+		double r = zr * zr - zi * zi + cre;
+		double im = 2 * zr * zi + cim;
+		frame.setEscaped(pixel, iters + 1, r * r + im * im);
+		iterations += steps + 1;
+	}
+	return iterations;
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include "BlaTable.h"
+#include "FloatExp.h"
+#include "Kernel.h"
+#include "ReferenceOrbit.h"
+#include "SeriesApproximation.h"
+
+// Deep zoom kernel: one reference orbit is iterated in BigFixed and every pixel iterates only
+// its distance from that orbit,
+//   d(n+1) = 2 Z(n) d(n) + d(n)^2 + dc
+// in double, or in FloatExp for as long as d is too small for double.
+// Pixels whose distance collapses against the reference are marked glitched (Frame::setGlitched)
+// so the renderer can re-evaluate them against a reference chosen inside the glitch.
+// evaluate() counts every step it takes as one iteration, a BLA step over a run included; iterations
+// the series approximation skips are not counted.
+class PerturbationKernel : public Kernel {
+public:
+	// Pauldelbrot's criterion: |Z + d|^2 < tolerance * |Z|^2 means d has cancelled the reference
+	static constexpr double glitch_tolerance = 1e-6;
+	// Below this log2 pixel size deltas start out in FloatExp
+	static constexpr double extended_log2_pixel_size = -960.0;
+	// A delta moves from FloatExp to double once |d|^2 exceeds 2^this
+	static constexpr double extended_log2_norm = -1800.0;
+
+	const char* name() const override { return "perturbation"; }
+	// Places the reference at the view center
+	void prepare(const View& view) override;
+	uint64_t evaluate(const View& view, Frame& frame, const unsigned int* pixels, size_t count) const override;
+
+	// Places the reference at the center of a pixel
+	void rebase(const View& view, unsigned int pixel);
+	// With detection off every pixel gets a best-effort result instead of being marked glitched
+	void setGlitchDetection(bool enabled) { detect_glitches = enabled; }
+	// Skips runs of iterations through the bilinear approximation table; takes effect at the next prepare()
+	void setBla(bool enabled) { use_bla = enabled; }
+	// Starts every pixel from the series approximation; takes effect at the next prepare()
+	void setSeries(bool enabled) { use_series = enabled; }
+
+	int seriesSkip() const { return extended ? series_exp.skip() : series.skip(); }
+	bool extendedRange() const { return extended; }
+
+	const ReferenceOrbit& reference() const { return orbit; }
+
+private:
+	void buildApproximations(const View& view);
+	// Runs the FloatExp phase of one pixel; returns the iteration it stopped at and d rounded to double,
+	// and adds the steps it took to steps
+	int iterateExtended(const View& view, double px, double py, double& dzr, double& dzi, int& steps) const;
+
+	ReferenceOrbit orbit;
+	BlaTable<double> table;
+	BlaTable<FloatExp> table_exp;
+	SeriesApproximation<double> series;
+	SeriesApproximation<FloatExp> series_exp;
+	// Offset of the reference from the view center, in pixels
+	double ref_x = 0.0, ref_y = 0.0;
+	bool extended = false;
+	bool detect_glitches = true;
+	bool use_bla = true;
+	bool use_series = true;
+};
@@ -0,0 +1,188 @@
+#include "Png.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <fstream>
+#include <vector>
+
+namespace {
+
+// Deflate streams are filled from the least significant bit of each byte
+class BitWriter {
+public:
+	explicit BitWriter(std::vector<uint8_t>& out) : out(out) {}
+
+	void write(uint32_t bits, int count) {
+		buffer |= (uint64_t)bits << filled;
+		filled += count;
+		while (filled >= 8) {
+			out.push_back((uint8_t)buffer);
+			buffer >>= 8;
+			filled -= 8;
+		}
+	}
+
+	// Huffman codes are stored most significant bit first
+	void writeCode(uint32_t code, int length) {
+		uint32_t reversed = 0;
+		for (int i = 0; i < length; i++) {
+			reversed = reversed << 1 | (code >> i & 1);
+		}
+		write(reversed, length);
+	}
+
+	void flush() {
+		if (filled > 0) {
+			out.push_back((uint8_t)buffer);
+			buffer = 0;
+			filled = 0;
+		}
+	}
+
+private:
+	std::vector<uint8_t>& out;
+	uint64_t buffer = 0;
+	int filled = 0;
+};
+
+// Literal/length symbol in the fixed Huffman code of RFC 1951, 3.2.6
+void writeSymbol(BitWriter& bits, unsigned int symbol) {
+	if (symbol < 144) {
+		bits.writeCode(0x30 + symbol, 8);
+	} else if (symbol < 256) {
+		bits.writeCode(0x190 + symbol - 144, 9);
+	} else if (symbol < 280) {
+		bits.writeCode(symbol - 256, 7);
+	} else {
+		bits.writeCode(0xc0 + symbol - 280, 8);
+	}
+}
+
+// A copy of the previous byte, length in [3, 258]
+void writeRun(BitWriter& bits, unsigned int length) {
+	static const unsigned int bases[29] = { 3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99,
+		115, 131, 163, 195, 227, 258 };
+	static const int extra[29] = { 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+	int code = 28;
+	while (bases[code] > length) {
+		code--;
+	}
+	writeSymbol(bits, 257 + code);
+	bits.write(length - bases[code], extra[code]);
+	// Distance 1 is distance code 0
+	bits.writeCode(0, 5);
+}
+
+std::vector<uint8_t> deflate(const std::vector<uint8_t>& data) {
+	const unsigned int max_run = 258;
+	std::vector<uint8_t> out = { 0x78, 0x01 };
+	BitWriter bits(out);
+	// One final block with the fixed codes
+	bits.write(1, 1);
+	bits.write(1, 2);
+	size_t i = 0;
+	while (i < data.size()) {
+		size_t run = 0;
+		while (i > 0 && i + run < data.size() && run < max_run && data[i + run] == data[i - 1]) {
+			run++;
+		}
+		if (run >= 3) {
+			writeRun(bits, (unsigned int)run);
+			i += run;
+		} else {
+			writeSymbol(bits, data[i]);
+			i++;
+		}
+	}
+	writeSymbol(bits, 256);
+	bits.flush();
+
+	uint32_t a = 1, b = 0;
+	for (uint8_t byte : data) {
+		a = (a + byte) % 65521;
+		b = (b + a) % 65521;
+	}
+	uint32_t adler = b << 16 | a;
+	for (int shift = 24; shift >= 0; shift -= 8) {
+		out.push_back((uint8_t)(adler >> shift));
+	}
+	return out;
+}
+
+std::vector<uint32_t> crcTable() {
+	std::vector<uint32_t> table(256);
+	for (uint32_t n = 0; n < 256; n++) {
+		uint32_t c = n;
+		for (int k = 0; k < 8; k++) {
+			c = c & 1 ? 0xedb88320u ^ c >> 1 : c >> 1;
+		}
+		table[n] = c;
+	}
+	return table;
+}
+
+uint32_t crc32(const uint8_t* data, size_t size) {
+	static const std::vector<uint32_t> table = crcTable();
+	uint32_t crc = 0xffffffffu;
+	for (size_t i = 0; i < size; i++) {
+		crc = table[(crc ^ data[i]) & 0xff] ^ crc >> 8;
+	}
+	return ~crc;
+}
+
+void putBigEndian(std::vector<uint8_t>& out, uint32_t value) {
+	for (int shift = 24; shift >= 0; shift -= 8) {
+		out.push_back((uint8_t)(value >> shift));
+	}
+}
+
+void writeChunk(std::ofstream& file, const char* type, const uint8_t* data, size_t size) {
+	std::vector<uint8_t> chunk;
+	putBigEndian(chunk, (uint32_t)size);
+	chunk.insert(chunk.end(), type, type + 4);
+	chunk.insert(chunk.end(), data, data + size);
+	putBigEndian(chunk, crc32(chunk.data() + 4, chunk.size() - 4));
+	file.write((const char*)chunk.data(), chunk.size());
+}
+
+}
+
+bool writePng(const std::string& path, const Frame& frame) {
+	std::ofstream file(path, std::ios::binary);
+	if (!file.is_open()) {
+		return false;
+	}
+
+	// Each byte minus the same channel of the pixel to its left, so flat areas become runs of zeros
+	const uint8_t sub_filter = 1;
+	std::vector<uint8_t> rows;
+	rows.reserve(((size_t)frame.width * 3 + 1) * frame.height);
+	for (unsigned int y = frame.height; y-- > 0;) {
+		rows.push_back(sub_filter);
+		uint32_t left = 0;
+		for (unsigned int x = 0; x < frame.width; x++) {
+			uint32_t pixel = frame.pixels[(size_t)y * frame.width + x];
+			for (int channel = 0; channel < 3; channel++) {
+				rows.push_back((uint8_t)((pixel >> 8 * channel) - (left >> 8 * channel)));
+			}
+			left = pixel;
+		}
+	}
+
+	static const uint8_t signature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n' };
+	file.write((const char*)signature, sizeof(signature));
+	std::vector<uint8_t> header;
+	putBigEndian(header, frame.width);
+	putBigEndian(header, frame.height);
+	// 8 bits per channel, RGB, deflate, adaptive filtering, no interlace
+	header.insert(header.end(), { 8, 2, 0, 0, 0 });
+	writeChunk(file, "IHDR", header.data(), header.size());
+	// Chunks are limited to 2^31 - 1 bytes; smaller ones keep the copies with their CRC small as well
+	const size_t max_chunk = 1 << 20;
+	std::vector<uint8_t> compressed = deflate(rows);
+	for (size_t offset = 0; offset < compressed.size(); offset += max_chunk) {
+		writeChunk(file, "IDAT", compressed.data() + offset, std::min(max_chunk, compressed.size() - offset));
+	}
+	writeChunk(file, "IEND", nullptr, 0);
+	return file.good();
+}
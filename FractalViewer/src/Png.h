@@ -0,0 +1,10 @@
+#pragma once
+
+#include "Kernel.h"
+
+#include <string>
+
+// Writes the pixels of frame as an 8-bit RGB PNG, top row first. There is no zlib here, so rows go
+// through the Sub filter and runs of equal bytes are deflated with the fixed Huffman codes, which is
+// enough for the large flat areas of fractal images.
+bool writePng(const std::string& path, const Frame& frame);
@@ -0,0 +1,35 @@
+#include "ReferenceOrbit.h"
+
+void ReferenceOrbit::compute(const BigFixed& cre, const BigFixed& cim, int max_iters, unsigned int fracLimbs) {
+	this->cre = cre.withPrecision(fracLimbs);
+	this->cim = cim.withPrecision(fracLimbs);
+	re.assign(1, 0.0);
+	im.assign(1, 0.0);
+	re.reserve(max_iters + 1);
+	im.reserve(max_iters + 1);
+
+	// 2 re im = (re + im)^2 - re^2 - im^2 turns the multiply into a third square, and the in-place
+	// operations reuse the same limbs every iteration
+	BigFixed zre(0.0, fracLimbs), zim(0.0, fracLimbs);
+	BigFixed re2 = zre, im2 = zre, sum = zre;
+	BigFixed::Workspace work;
+	for (int n = 0; n < max_iters; n++) {
+		BigFixed::square(zre, re2, work);
+		BigFixed::square(zim, im2, work);
+		BigFixed::add(zre, zim, sum);
+		BigFixed::square(sum, sum, work);
+		BigFixed::subtract(sum, re2, sum);
+		BigFixed::subtract(sum, im2, sum);
+		BigFixed::add(sum, this->cim, zim);
+		BigFixed::subtract(re2, im2, zre);
+		BigFixed::add(zre, this->cre, zre);
+
+		double r = zre.toDouble();
+		double i = zim.toDouble();
+		re.push_back(r);
+		im.push_back(i);
+		if (r * r + i * i > 4.0) {
+			break;
+		}
+	}
+}
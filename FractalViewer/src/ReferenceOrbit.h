@@ -0,0 +1,17 @@
+#pragma once
+
+#include "BigFixed.h"
+
+#include <vector>
+
+// Orbit of one point iterated in BigFixed and rounded to double for the perturbation loop.
+class ReferenceOrbit {
+public:
+	void compute(const BigFixed& cre, const BigFixed& cim, int max_iters, unsigned int fracLimbs);
+
+	// Index of the last stored Z_n; the orbit escaped there unless it equals max_iters
+	int last() const { return (int)re.size() - 1; }
+
+	BigFixed cre, cim;
+	std::vector<double> re, im;
+};
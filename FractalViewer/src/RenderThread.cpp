@@ -0,0 +1,119 @@
+#include "RenderThread.h"
+#include "Trace.h"
+
+static bool sameView(const View& a, const View& b) {
+	return a.width == b.width && a.height == b.height && a.zoom_level == b.zoom_level && a.max_iters == b.max_iters &&
+		(a.pos_x - b.pos_x).isZero() && (a.pos_y - b.pos_y).isZero();
+}
+
+RenderThread::RenderThread(Renderer& renderer, FrameStats* stats) : renderer(renderer), stats(stats) {
+	reported = renderer.totals();
+	thread = std::thread(&RenderThread::run, this);
+}
+
+RenderThread::~RenderThread() {
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stopping = true;
+	}
+	wake.notify_one();
+	thread.join();
+}
+
+void RenderThread::submit(const Request& request) {
+	std::unique_ptr<Request> posted = std::make_unique<Request>(request);
+	posted->submitted = std::chrono::steady_clock::now();
+	requests.post(std::move(posted));
+	std::lock_guard<std::mutex> lock(mutex);
+	wake.notify_one();
+}
+
+void RenderThread::run() {
+	setTraceThreadName("render");
+	while (!stopping) {
+		std::unique_ptr<Request> request = requests.take();
+		if (request) {
+			apply(*request);
+		} else if (renderer.refining()) {
+			renderer.refine(frame, slice_seconds);
+			publish();
+		} else if (has_view && !renderer.iterationBudget().settled()) {
+			// An unsettled budget renders the same view again until it stops changing; a frame with
+			// nothing to preview from starts over, or this loop would spin without rendering
+			if (!renderer.preview(current.view, frame)) {
+				renderer.begin(current.view, frame);
+			}
+		} else {
+			std::unique_lock<std::mutex> lock(mutex);
+			wake.wait(lock, [this] { return stopping || !requests.empty(); });
+		}
+	}
+}
+
+void RenderThread::apply(const Request& request) {
+	bool colors_changed = request.scheme != current.scheme || request.mode != current.mode ||
+		request.palette_offset != current.palette_offset;
+	bool view_changed = !has_view || !sameView(request.view, current.view);
+	bool zoomed = has_view && request.view.zoom_level != current.view.zoom_level;
+
+	// A superseded request's partial frame is not a sample of either stage
+	frame_iterate = 0.0;
+	frame_color = 0.0;
+	frame_pending = true;
+
+	Palette& palette = renderer.palette();
+	palette.setScheme(request.scheme);
+	palette.setMode(request.mode);
+	palette.setOffset(request.palette_offset);
+
+	if (view_changed) {
+		// Zooms, and moves away from a frame that is still unfinished, show the last frame resampled
+		// right away; anything else renders coarse to fine
+		if (!(zoomed || renderer.refining()) || !renderer.preview(request.view, frame)) {
+			renderer.begin(request.view, frame);
+		}
+	}
+	// A panned render only colors the new strips
+	if (colors_changed) {
+		renderer.recolor(frame);
+	}
+	current = request;
+	has_view = true;
+	publish();
+}
+
+void RenderThread::publish() {
+	std::unique_ptr<Image> image = std::make_unique<Image>();
+	image->width = frame.width;
+	image->height = frame.height;
+	image->pixels = frame.pixels;
+	image->max_iters = renderer.iterationBudget().current();
+	image->cap_fraction = renderer.iterationBudget().capFraction();
+	images.post(std::move(image));
+
+	Renderer::Totals totals = renderer.totals();
+	if (stats) {
+		double iterate = totals.iterate_seconds - reported.iterate_seconds;
+		double color = totals.color_seconds - reported.color_seconds;
+		if (iterate > 0.0) {
+			stats->addIterations(totals.iterations - reported.iterations, iterate);
+		}
+		stats->setBudget(renderer.iterationBudget().current(), renderer.iterationBudget().capFraction());
+		frame_iterate += iterate;
+		frame_color += color;
+		// Finished once no pass is left and the budget doesn't call for another render
+		if (frame_pending && !renderer.refining() && renderer.iterationBudget().settled()) {
+			// Frames that only needed one of the stages don't count as samples of the other
+			if (frame_iterate > 0.0) {
+				stats->record(FrameStats::Stage::Iterate, frame_iterate);
+			}
+			if (frame_color > 0.0) {
+				stats->record(FrameStats::Stage::Color, frame_color);
+			}
+			stats->record(FrameStats::Stage::Latency,
+				std::chrono::duration<double>(std::chrono::steady_clock::now() - current.submitted).count());
+			frame_pending = false;
+		}
+	}
+	reported = totals;
+}
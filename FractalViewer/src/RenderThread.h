@@ -0,0 +1,73 @@
+#pragma once
+
+#include "FrameStats.h"
+#include "Mailbox.h"
+#include "Renderer.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+// Runs a Renderer on its own thread so the thread handling input never waits for a frame.
+// The input side posts snapshots of what it wants to see and picks up the newest image; requests
+// and images that were superseded before the other side got to them are dropped, not queued.
+class RenderThread {
+public:
+	struct Request {
+		View view;
+		Palette::Scheme scheme = Palette::Scheme::Rainbow;
+		Palette::Mode mode = Palette::Mode::Smooth;
+		double palette_offset = 0.0;
+		// Set by submit(); the latency of a finished image is counted from here
+		std::chrono::steady_clock::time_point submitted;
+	};
+
+	struct Image {
+		unsigned int width = 0, height = 0;
+		std::vector<uint32_t> pixels;
+		// Iteration budget and fraction of pixels that reached it, see IterationBudget
+		int max_iters = 0;
+		double cap_fraction = 0.0;
+	};
+
+	// Time spent on a frame before the render thread looks for a newer request, about one frame at 60 Hz
+	static constexpr double slice_seconds = 1.0 / 60.0;
+
+	// renderer must not be used by anyone else while the thread runs. With stats, each finished frame
+	// records the time spent iterating and coloring it and its latency since submit().
+	explicit RenderThread(Renderer& renderer, FrameStats* stats = nullptr);
+	~RenderThread();
+
+	RenderThread(const RenderThread&) = delete;
+	RenderThread& operator=(const RenderThread&) = delete;
+
+	void submit(const Request& request);
+	// The image published since the last call, or null
+	std::unique_ptr<Image> latest() { return images.take(); }
+
+private:
+	void run();
+	void apply(const Request& request);
+	void publish();
+
+	Renderer& renderer;
+	FrameStats* stats;
+	// Renderer totals at the last publish()
+	Renderer::Totals reported = {};
+	// Iterate and color time spent on the current request so far, recorded once its frame is finished
+	double frame_iterate = 0.0, frame_color = 0.0;
+	bool frame_pending = false;
+	Frame frame;
+	Request current;
+	bool has_view = false;
+
+	Mailbox<Request> requests;
+	Mailbox<Image> images;
+
+	// Guards only the sleep of an idle render thread; submit() holds it just long enough to wake it
+	std::mutex mutex;
+	std::condition_variable wake;
+	std::atomic<bool> stopping{ false };
+	std::thread thread;
+};
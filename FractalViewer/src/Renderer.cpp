@@ -0,0 +1,544 @@
+#include "Renderer.h"
+#include "CpuFeatures.h"
+#include "MarianiSilver.h"
+#include "Trace.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <map>
+
+namespace {
+
+// Passes on only the pixels no earlier pass has iterated
+class UnknownPixelsKernel : public Kernel {
+public:
+	UnknownPixelsKernel(const Kernel& inner, const std::vector<uint8_t>& known) : inner(inner), known(known) {}
+
+	const char* name() const override { return inner.name(); }
+
+	uint64_t evaluate(const View& view, Frame& frame, const unsigned int* pixels, size_t count) const override {
+		unsigned int chunk[256];
+		size_t n = 0;
+		uint64_t iterations = 0;
+		for (size_t i = 0; i < count; i++) {
+			if (!known[pixels[i]]) {
+				chunk[n++] = pixels[i];
+			}
+			if (n == 256) {
+				iterations += inner.evaluate(view, frame, chunk, n);
+				n = 0;
+			}
+		}
+		if (n > 0) {
+			iterations += inner.evaluate(view, frame, chunk, n);
+		}
+		return iterations;
+	}
+
+private:
+	const Kernel& inner;
+	const std::vector<uint8_t>& known;
+};
+
+// Adds up the iterations the inner kernel reports
+class CountingKernel : public Kernel {
+public:
+	CountingKernel(const Kernel& inner, std::atomic<uint64_t>& iterations) : inner(inner), iterations(iterations) {}
+
+	const char* name() const override { return inner.name(); }
+
+	uint64_t evaluate(const View& view, Frame& frame, const unsigned int* pixels, size_t count) const override {
+		uint64_t sum = inner.evaluate(view, frame, pixels, count);
+		iterations.fetch_add(sum, std::memory_order_relaxed);
+		return sum;
+	}
+
+private:
+	const Kernel& inner;
+	std::atomic<uint64_t>& iterations;
+};
+
+double secondsSince(std::chrono::steady_clock::time_point start) {
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Adds the time until it goes out of scope to total
+class StageTimer {
+public:
+	explicit StageTimer(double& total) : total(total) {}
+	~StageTimer() { total += secondsSince(start); }
+
+private:
+	double& total;
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+};
+
+// Like StageTimer, but leaves out the time that went into coloring meanwhile
+class IterateTimer {
+public:
+	IterateTimer(double& total, const double& color_total) : total(total), color_total(color_total), color_start(color_total) {}
+	~IterateTimer() { total += secondsSince(start) - (color_total - color_start); }
+
+private:
+	double& total;
+	const double& color_total;
+	double color_start;
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+};
+
+}
+
+Renderer::Renderer(TileScheduler& scheduler) : Renderer(scheduler, createKernel()) {}
+
+Renderer::Renderer(TileScheduler& scheduler, std::unique_ptr<Kernel> kernel)
+	: scheduler(scheduler), kernel(std::move(kernel)), double_double(bestKernelIsa()),
+	scratch(scheduler.threadCount()), glitches(scheduler.threadCount()), tracers(scheduler.threadCount()) {}
+
+Kernel& Renderer::kernelFor(const View& view) {
+	if (view.pixelSize() < deep_pixel_size) {
+		return perturbation;
+	}
+	return *kernel;
+}
+
+bool Renderer::setUp(View& view, Frame& frame) {
+	if (frame.width != view.width || frame.height != view.height) {
+		frame.resize(view.width, view.height);
+	}
+	if (tiles_width != view.width || tiles_height != view.height) {
+		tiles = makeTiles(view.width, view.height, tile_size);
+		tiles_width = view.width;
+		tiles_height = view.height;
+	}
+
+	// A frame that is still a preview or a coarse pass has nothing exact to shift
+	bool unfinished = !passes.empty();
+	if (unfinished) {
+		passes.clear();
+		collectGlitches();
+	}
+	int dx, dy;
+	if (unfinished || !panOffset(view, frame, dx, dy)) {
+		return false;
+	}
+	// The shifted pixels were iterated with the last budget, so the strips have to be as well
+	view.max_iters = last.max_iters;
+	renderPan(kernelFor(view), view, frame, dx, dy);
+	last = view;
+	return true;
+}
+
+void Renderer::render(const View& requested, Frame& frame) {
+	TraceScope scope("render");
+	IterateTimer timer(iterate_seconds, color_seconds);
+	View view = requested;
+	if (!setUp(view, frame)) {
+		Kernel& kernel = kernelFor(view);
+		if (adaptive_iterations) {
+			view.max_iters = chooseBudget(kernel, view, frame);
+		} else {
+			kernel.prepare(view);
+		}
+		evaluateTiles(kernel, view, frame, tiles);
+		if (&kernel == &perturbation) {
+			resolveGlitches(view, frame);
+		}
+		if (adaptive_iterations) {
+			budget.observe(frame);
+		}
+		recolor(frame);
+		last = view;
+	}
+	last_frame = &frame;
+}
+
+void Renderer::begin(const View& requested, Frame& frame) {
+	TraceScope scope("begin");
+	IterateTimer timer(iterate_seconds, color_seconds);
+	View view = requested;
+	if (setUp(view, frame)) {
+		last_frame = &frame;
+		return;
+	}
+
+	known.assign(frame.pixels.size(), 0);
+	for (unsigned int step : coarse_steps) {
+		passes.push_back({ step, tiles });
+	}
+	passes.push_back({ 1, tiles });
+	startPasses(view);
+	last = view;
+	last_frame = &frame;
+}
+
+bool Renderer::panOffset(const View& view, const Frame& frame, int& dx, int& dy) const {
+	if (last_frame != &frame || view.width != last.width || view.height != last.height || view.zoom_level != last.zoom_level ||
+		(!adaptive_iterations && view.max_iters != last.max_iters)) {
+		return false;
+	}
+	FloatExp size = view.pixelSizeExp();
+	double x = (view.pos_x - last.pos_x).scaledToDouble(-size.e) / size.m;
+	double y = (view.pos_y - last.pos_y).scaledToDouble(-size.e) / size.m;
+	dx = (int)std::lround(x);
+	dy = (int)std::lround(y);
+	// Sub-pixel moves can't reuse anything; the caller snaps its pans to whole pixels to avoid them
+	if (fabs(x - dx) > pan_tolerance || fabs(y - dy) > pan_tolerance) {
+		return false;
+	}
+	// Nothing moved: render again, which lets an adaptive budget settle
+	if (dx == 0 && dy == 0) {
+		return false;
+	}
+	return (unsigned int)abs(dx) < view.width && (unsigned int)abs(dy) < view.height;
+}
+
+void Renderer::renderPan(Kernel& kernel, const View& view, Frame& frame, int dx, int dy) {
+	frame.shift(dx, dy);
+
+	// A column strip over the full height on the side the view moved to, and a row strip beside it
+	strips.clear();
+	unsigned int w = view.width, h = view.height;
+	unsigned int x0 = 0, x1 = w;
+	if (dx > 0) {
+		makeTiles({ w - dx, 0, w, h }, tile_size, strips);
+		x1 = w - dx;
+	} else if (dx < 0) {
+		makeTiles({ 0, 0, (unsigned int)-dx, h }, tile_size, strips);
+		x0 = -dx;
+	}
+	if (dy > 0) {
+		makeTiles({ x0, h - dy, x1, h }, tile_size, strips);
+	} else if (dy < 0) {
+		makeTiles({ x0, 0, x1, (unsigned int)-dy }, tile_size, strips);
+	}
+
+	kernel.prepare(view);
+	evaluateTiles(kernel, view, frame, strips);
+	if (&kernel == &perturbation) {
+		resolveGlitches(view, frame);
+	}
+	recolorTiles(frame, strips);
+}
+
+void Renderer::recolor(Frame& frame) {
+	StageTimer timer(color_seconds);
+	const size_t chunk = tile_size * tile_size * 16;
+	scheduler.run((frame.pixels.size() + chunk - 1) / chunk, [&](size_t index, unsigned int /*worker*/) {
+		TraceScope scope("recolor");
+		colors.apply(frame, index * chunk, std::min(frame.pixels.size(), (index + 1) * chunk));
+	});
+}
+
+bool Renderer::preview(const View& view, Frame& frame) {
+	if (last_frame != &frame || view.width != last.width || view.height != last.height) {
+		return false;
+	}
+	TraceScope scope("preview");
+	passes.clear();
+
+	// Old pixel coordinate of new pixel x: origin + (x + 0.5 - width / 2) * ratio + width / 2 - 0.5
+	FloatExp size = last.pixelSizeExp();
+	double ratio = exp(last.zoom_level - view.zoom_level);
+	double origin_x = (view.pos_x - last.pos_x).scaledToDouble(-size.e) / size.m;
+	double origin_y = (view.pos_y - last.pos_y).scaledToDouble(-size.e) / size.m;
+
+	previous = frame;
+	covered.assign(frame.pixels.size(), 0);
+	for (unsigned int y = 0; y < view.height; y++) {
+		long long sy = std::llround(origin_y + (y + 0.5 - view.height * 0.5) * ratio + view.height * 0.5 - 0.5);
+		for (unsigned int x = 0; x < view.width; x++) {
+			long long sx = std::llround(origin_x + (x + 0.5 - view.width * 0.5) * ratio + view.width * 0.5 - 0.5);
+			size_t index = (size_t)y * view.width + x;
+			if (sx < 0 || sy < 0 || sx >= view.width || sy >= view.height) {
+				frame.setInterior(index, last.max_iters);
+				frame.pixels[index] = 0xff000000u;
+				continue;
+			}
+			size_t source = (size_t)sy * view.width + (size_t)sx;
+			frame.iterations[index] = previous.iterations[source];
+			frame.smooth[index] = previous.smooth[source];
+			frame.norms[index] = previous.norms[source];
+			frame.pixels[index] = previous.pixels[source];
+			covered[index] = 1;
+		}
+	}
+
+	queuePreview(view);
+	// The preview still holds results of the last budget
+	int max_iters = last.max_iters;
+	last = view;
+	last.max_iters = max_iters;
+	return true;
+}
+
+bool Renderer::refine(Frame& frame, double seconds) {
+	if (passes.empty()) {
+		return false;
+	}
+	TraceScope scope("refine");
+	IterateTimer timer(iterate_seconds, color_seconds);
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	Kernel& kernel = kernelFor(refining_view);
+	if (!refine_started) {
+		if (adaptive_iterations) {
+			refining_view.max_iters = chooseBudget(kernel, refining_view, frame);
+		} else {
+			kernel.prepare(refining_view);
+		}
+		refine_started = true;
+	}
+
+	// A few tiles per thread at a time, so the time is checked often enough
+	size_t count = scheduler.threadCount() * 2;
+	do {
+		const Pass& pass = passes[current_pass];
+		// Coarse passes iterate few pixels per tile and can take more tiles at once
+		size_t end = std::min(next_tile + count * pass.step, pass.tiles.size());
+		batch.assign(pass.tiles.begin() + next_tile, pass.tiles.begin() + end);
+		if (pass.step > 1) {
+			samplePass(kernel, frame, batch, pass.step);
+		} else {
+			UnknownPixelsKernel remaining(kernel, known);
+			evaluateTiles(remaining, refining_view, frame, batch);
+			recolorTiles(frame, batch);
+		}
+		next_tile += batch.size();
+		if (next_tile == pass.tiles.size()) {
+			// The full-resolution pass finds every glitched pixel again, samples included
+			if (pass.step > 1) {
+				collectGlitches();
+			}
+			current_pass++;
+			next_tile = 0;
+		}
+	} while (current_pass < passes.size() && secondsSince(start) < seconds);
+	if (current_pass < passes.size()) {
+		return true;
+	}
+
+	passes.clear();
+	if (&kernel == &perturbation) {
+		resolveGlitches(refining_view, frame);
+		recolor(frame);
+	}
+	if (adaptive_iterations) {
+		budget.observe(frame);
+	}
+	last = refining_view;
+	return false;
+}
+
+void Renderer::samplePass(Kernel& sampled, Frame& frame, const std::vector<Tile>& area, unsigned int step) {
+	const View& view = refining_view;
+	CountingKernel kernel(sampled, iterations);
+	scheduler.run(area.size(), [&](size_t index, unsigned int worker) {
+		const Tile& tile = area[index];
+		TraceScope scope("coarse tile", tile.x0, tile.y0);
+		unsigned int x0 = (tile.x0 + step - 1) / step * step, y0 = (tile.y0 + step - 1) / step * step;
+		std::vector<unsigned int>& pixels = scratch[worker];
+		pixels.clear();
+		for (unsigned int y = y0; y < tile.y1; y += step) {
+			for (unsigned int x = x0; x < tile.x1; x += step) {
+				if (!known[(size_t)y * view.width + x]) {
+					pixels.push_back(y * view.width + x);
+				}
+			}
+		}
+		kernel.evaluate(view, frame, pixels.data(), pixels.size());
+
+		// Every sample stands in for the block up to the next one until a finer pass replaces it
+		for (unsigned int y = y0; y < tile.y1; y += step) {
+			for (unsigned int x = x0; x < tile.x1; x += step) {
+				size_t sample = (size_t)y * view.width + x;
+				known[sample] = 1;
+				uint32_t color = colors.color(frame, sample);
+				frame.pixels[sample] = color;
+				for (unsigned int by = y; by < std::min(y + step, tile.y1); by++) {
+					for (unsigned int bx = x; bx < std::min(x + step, tile.x1); bx++) {
+						size_t pixel = (size_t)by * view.width + bx;
+						if (!known[pixel]) {
+							frame.copyResult(pixel, sample);
+							frame.pixels[pixel] = color;
+						}
+					}
+				}
+			}
+		}
+	});
+}
+
+void Renderer::queuePreview(const View& view) {
+	std::vector<std::pair<double, size_t>> order;
+	for (size_t i = 0; i < tiles.size(); i++) {
+		const Tile& tile = tiles[i];
+		bool missing = false;
+		for (unsigned int y = tile.y0; y < tile.y1 && !missing; y++) {
+			for (unsigned int x = tile.x0; x < tile.x1 && !missing; x++) {
+				missing = !covered[(size_t)y * view.width + x];
+			}
+		}
+		double cx = (tile.x0 + tile.x1) * 0.5 - view.width * 0.5, cy = (tile.y0 + tile.y1) * 0.5 - view.height * 0.5;
+		// Missing tiles sort ahead of every covered one
+		order.push_back({ (missing ? 0.0 : 1e12) + cx * cx + cy * cy, i });
+	}
+	std::sort(order.begin(), order.end());
+	Pass pass = { 1, {} };
+	for (const std::pair<double, size_t>& entry : order) {
+		pass.tiles.push_back(tiles[entry.second]);
+	}
+	passes.push_back(std::move(pass));
+	known.assign(covered.size(), 0);
+	startPasses(view);
+}
+
+void Renderer::startPasses(const View& view) {
+	current_pass = 0;
+	next_tile = 0;
+	refine_started = false;
+	refining_view = view;
+	// Glitches of an interrupted pass belong to another view
+	collectGlitches();
+}
+
+void Renderer::recolorTiles(Frame& frame, const std::vector<Tile>& area) {
+	StageTimer timer(color_seconds);
+	scheduler.run(area.size(), [&](size_t index, unsigned int /*worker*/) {
+		const Tile& tile = area[index];
+		TraceScope scope("recolor tile", tile.x0, tile.y0);
+		for (unsigned int y = tile.y0; y < tile.y1; y++) {
+			colors.apply(frame, (size_t)y * frame.width + tile.x0, (size_t)y * frame.width + tile.x1);
+		}
+	});
+}
+
+int Renderer::chooseBudget(Kernel& kernel, View& view, Frame& frame) {
+	TraceScope scope("budget probe");
+	// The kernel is prepared once for the probe limit; a reference orbit that runs longer than the
+	// budget still serves the frame
+	view.max_iters = budget.probeLimit();
+	kernel.prepare(view);
+	budget.probePixels(view, probe);
+	evaluateList(kernel, view, frame, probe);
+	collectGlitches();
+	return budget.choose(frame, probe);
+}
+
+void Renderer::evaluateTiles(Kernel& evaluated, const View& view, Frame& frame, const std::vector<Tile>& area) {
+	CountingKernel kernel(evaluated, iterations);
+	scheduler.run(area.size(), [&](size_t index, unsigned int worker) {
+		const Tile& tile = area[index];
+		TraceScope scope("tile", tile.x0, tile.y0);
+		std::vector<unsigned int>& pixels = scratch[worker];
+		switch (tile_method) {
+		case TileMethod::MarianiSilver:
+			subdivideTile(kernel, view, frame, tile, pixels);
+			break;
+		case TileMethod::BoundaryTrace:
+			tracers[worker].traceTile(kernel, view, frame, tile);
+			break;
+		default:
+			pixels.clear();
+			for (unsigned int y = tile.y0; y < tile.y1; y++) {
+				for (unsigned int x = tile.x0; x < tile.x1; x++) {
+					pixels.push_back(y * view.width + x);
+				}
+			}
+			kernel.evaluate(view, frame, pixels.data(), pixels.size());
+			break;
+		}
+		for (unsigned int y = tile.y0; y < tile.y1; y++) {
+			for (unsigned int x = tile.x0; x < tile.x1; x++) {
+				if (frame.isGlitched(y * view.width + x)) {
+					glitches[worker].push_back(y * view.width + x);
+				}
+			}
+		}
+	});
+}
+
+void Renderer::evaluateList(Kernel& evaluated, const View& view, Frame& frame, const std::vector<unsigned int>& pixels) {
+	CountingKernel kernel(evaluated, iterations);
+	const size_t chunk = tile_size * tile_size;
+	scheduler.run((pixels.size() + chunk - 1) / chunk, [&](size_t index, unsigned int worker) {
+		const unsigned int* first = pixels.data() + index * chunk;
+		size_t count = std::min(chunk, pixels.size() - index * chunk);
+		TraceScope scope("pixels");
+		kernel.evaluate(view, frame, first, count);
+		for (size_t i = 0; i < count; i++) {
+			if (frame.isGlitched(first[i])) {
+				glitches[worker].push_back(first[i]);
+			}
+		}
+	});
+}
+
+std::vector<unsigned int> Renderer::collectGlitches() {
+	std::vector<unsigned int> all;
+	for (std::vector<unsigned int>& list : glitches) {
+		all.insert(all.end(), list.begin(), list.end());
+		list.clear();
+	}
+	return all;
+}
+
+unsigned int Renderer::chooseReference(const View& view, const Frame& frame, const std::vector<unsigned int>& glitched) const {
+	// Pixels that glitched at the same iteration usually belong to the same blob; take the biggest group
+	// and the member closest to its centroid, which keeps the new reference inside the blob.
+	std::map<int, size_t> groups;
+	for (unsigned int pixel : glitched) {
+		groups[frame.glitchIteration(pixel)]++;
+	}
+	int group = std::max_element(groups.begin(), groups.end(),
+		[](const std::pair<const int, size_t>& a, const std::pair<const int, size_t>& b) { return a.second < b.second; })->first;
+
+	double sx = 0.0, sy = 0.0;
+	size_t n = 0;
+	for (unsigned int pixel : glitched) {
+		if (frame.glitchIteration(pixel) == group) {
+			sx += pixel % view.width;
+			sy += pixel / view.width;
+			n++;
+		}
+	}
+	sx /= n;
+	sy /= n;
+
+	unsigned int best = glitched[0];
+	double bestDistance = -1.0;
+	for (unsigned int pixel : glitched) {
+		if (frame.glitchIteration(pixel) != group) {
+			continue;
+		}
+		double dx = pixel % view.width - sx, dy = pixel / view.width - sy;
+		double distance = dx * dx + dy * dy;
+		if (bestDistance < 0 || distance < bestDistance) {
+			best = pixel;
+			bestDistance = distance;
+		}
+	}
+	return best;
+}
+
+void Renderer::resolveGlitches(const View& view, Frame& frame) {
+	TraceScope scope("glitches");
+	std::vector<unsigned int> glitched = collectGlitches();
+	if (!glitched.empty() && view.pixelSize() >= double_double_pixel_size) {
+		double_double.prepare(view);
+		evaluateList(double_double, view, frame, glitched);
+		return;
+	}
+
+	for (int references = 0; !glitched.empty() && references < max_references; references++) {
+		perturbation.rebase(view, chooseReference(view, frame, glitched));
+		evaluateList(perturbation, view, frame, glitched);
+		glitched = collectGlitches();
+	}
+
+	if (!glitched.empty()) {
+		perturbation.setGlitchDetection(false);
+		evaluateList(perturbation, view, frame, glitched);
+		perturbation.setGlitchDetection(true);
+	}
+}
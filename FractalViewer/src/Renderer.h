@@ -0,0 +1,132 @@
+#pragma once
+
+#include "BoundaryTrace.h"
+#include "DoubleDoubleKernel.h"
+#include "IterationBudget.h"
+#include "Kernel.h"
+#include "Palette.h"
+#include "PerturbationKernel.h"
+#include "TileScheduler.h"
+
+#include <atomic>
+
+// How a tile decides which of its pixels to iterate
+enum class TileMethod {
+	// Every pixel
+	Full,
+	// Rectangles with an interior border are filled (MarianiSilver.h)
+	MarianiSilver,
+	// Only the contours of the iteration bands are iterated (BoundaryTrace.h)
+	BoundaryTrace
+};
+
+class Renderer {
+public:
+	static constexpr unsigned int tile_size = 32;
+	// Below this pixel size plain double pixels start to merge and the perturbation kernel takes over
+	static constexpr double deep_pixel_size = 1e-13;
+	// Down to this pixel size double-double is still exact, so glitched pixels are finished with it
+	// directly instead of paying for more references
+	static constexpr double double_double_pixel_size = 1e-28;
+	// Extra references tried per frame before the remaining glitched pixels are accepted as they are
+	static constexpr int max_references = 32;
+	// A view this close to a whole-pixel pan of the last frame reuses its pixels
+	static constexpr double pan_tolerance = 1e-3;
+	// Pixel spacing of the coarse passes of begin(); tile_size has to be a multiple of each
+	static constexpr unsigned int coarse_steps[] = { 16, 4 };
+
+	explicit Renderer(TileScheduler& scheduler);
+	Renderer(TileScheduler& scheduler, std::unique_ptr<Kernel> kernel);
+
+	Kernel& kernelFor(const View& view);
+
+	void setTileMethod(TileMethod method) { tile_method = method; }
+	// With adaptive iterations the max_iters of the rendered views is replaced by an IterationBudget
+	void setAdaptiveIterations(bool enabled) { adaptive_iterations = enabled; }
+	const IterationBudget& iterationBudget() const { return budget; }
+
+	// Palette changes take effect at the next render() or recolor()
+	Palette& palette() { return colors; }
+
+	// Rendering the same frame again after a whole-pixel pan only iterates the newly exposed strips
+	void render(const View& view, Frame& frame);
+	// Colors the iteration data frame already holds again, without iterating
+	void recolor(Frame& frame);
+
+	// Starts a progressive render that refine() carries out: every coarse_steps pixel first, each
+	// standing in for its block, then full resolution with the tile method, skipping the pixels the
+	// coarse passes already iterated. Whole-pixel pans are finished right away as in render().
+	void begin(const View& view, Frame& frame);
+	// Fills frame with the last frame resampled into view, for instant feedback on zooms, and queues
+	// every tile of view for refine(). Tiles with pixels the last frame didn't cover come first, then
+	// the ones nearest the center. Returns false when there is no last frame of the same size.
+	bool preview(const View& view, Frame& frame);
+	// Runs the queued passes for about the given time; false once the frame is finished. Starting
+	// another render drops whatever is left.
+	bool refine(Frame& frame, double seconds);
+	bool refining() const { return !passes.empty(); }
+
+	// Work done since construction, see FrameStats
+	struct Totals {
+		// Iterations the kernels actually ran; pixels filled in by tiling or reused from an earlier pass
+		// add nothing, and interior pixels count only the iterations before a check stopped them
+		uint64_t iterations;
+		// Time spent in render(), begin() and refine(), split into coloring and everything else
+		double iterate_seconds, color_seconds;
+	};
+	Totals totals() const { return { iterations.load(std::memory_order_relaxed), iterate_seconds, color_seconds }; }
+
+private:
+	// Whole-pixel offset of view from the last render into frame, if its pixels can be shifted
+	bool panOffset(const View& view, const Frame& frame, int& dx, int& dy) const;
+	void renderPan(Kernel& kernel, const View& view, Frame& frame, int dx, int dy);
+	void recolorTiles(Frame& frame, const std::vector<Tile>& area);
+	void evaluateTiles(Kernel& kernel, const View& view, Frame& frame, const std::vector<Tile>& area);
+	int chooseBudget(Kernel& kernel, View& view, Frame& frame);
+	void evaluateList(Kernel& kernel, const View& view, Frame& frame, const std::vector<unsigned int>& pixels);
+	std::vector<unsigned int> collectGlitches();
+	unsigned int chooseReference(const View& view, const Frame& frame, const std::vector<unsigned int>& glitched) const;
+	void resolveGlitches(const View& view, Frame& frame);
+	// Handles size changes and whole-pixel pans; false when view still has to be rendered
+	bool setUp(View& view, Frame& frame);
+	void samplePass(Kernel& kernel, Frame& frame, const std::vector<Tile>& area, unsigned int step);
+	void queuePreview(const View& view);
+	void startPasses(const View& view);
+
+	TileScheduler& scheduler;
+	std::unique_ptr<Kernel> kernel;
+	PerturbationKernel perturbation;
+	DoubleDoubleKernel double_double;
+	std::vector<Tile> tiles, strips;
+	unsigned int tiles_width = 0, tiles_height = 0;
+	TileMethod tile_method = TileMethod::MarianiSilver;
+	IterationBudget budget;
+	Palette colors;
+	bool adaptive_iterations = false;
+	std::vector<unsigned int> probe;
+	std::vector<std::vector<unsigned int>> scratch;
+	std::vector<std::vector<unsigned int>> glitches;
+	std::vector<BoundaryTracer> tracers;
+	View last;
+	const Frame* last_frame = nullptr;
+	struct Pass {
+		// Pixels on multiples of step are iterated; 1 is the full-resolution pass
+		unsigned int step;
+		std::vector<Tile> tiles;
+	};
+
+	// Progressive render or preview refinement in progress
+	View refining_view;
+	std::vector<Pass> passes;
+	std::vector<Tile> batch;
+	size_t current_pass = 0, next_tile = 0;
+	bool refine_started = false;
+	// Pixels a coarse pass has iterated
+	std::vector<uint8_t> known;
+	Frame previous;
+	// Per pixel of a preview, whether the last frame had a source for it
+	std::vector<uint8_t> covered;
+
+	std::atomic<uint64_t> iterations{ 0 };
+	double iterate_seconds = 0.0, color_seconds = 0.0;
+};
@@ -0,0 +1,97 @@
+#include "SeriesApproximation.h"
+
+#include <algorithm>
+#include <cmath>
+
+template <class T>
+using Complex = typename SeriesApproximation<T>::Complex;
+
+template <class T>
+static Complex<T> add(const Complex<T>& a, const Complex<T>& b) {
+	return { a.re + b.re, a.im + b.im };
+}
+
+template <class T>
+static Complex<T> mul(const Complex<T>& a, const Complex<T>& b) {
+	return { a.re * b.re - a.im * b.im, a.re * b.im + a.im * b.re };
+}
+
+template <class T>
+static T norm(const Complex<T>& a) {
+	return a.re * a.re + a.im * a.im;
+}
+
+template <class T>
+static Complex<T> evaluateSeries(const std::vector<Complex<T>>& coefficients, const Complex<T>& u) {
+	Complex<T> sum = { T(0.0), T(0.0) };
+	for (size_t k = coefficients.size(); k-- > 0;) {
+		sum = mul<T>(add<T>(sum, coefficients[k]), u);
+	}
+	return sum;
+}
+
+template <class T>
+void SeriesApproximation<T>::compute(const ReferenceOrbit& orbit, const std::vector<Complex>& probes, int limit) {
+	using std::isfinite;
+	using std::sqrt;
+
+	skip_iters = 0;
+	T r2 = T(0.0);
+	for (const Complex& probe : probes) {
+		r2 = std::max(r2, norm<T>(probe));
+	}
+	if (!(r2 > T(0.0))) {
+		return;
+	}
+	radius = sqrt(r2);
+
+	limit = std::min(limit, orbit.last());
+	const Complex zero = { T(0.0), T(0.0) };
+	std::vector<Complex> a(terms, zero), next(terms);
+	std::vector<Complex> exact(probes.size(), zero);
+	std::vector<Complex> scaled(probes.size());
+	for (size_t p = 0; p < probes.size(); p++) {
+		scaled[p] = { probes[p].re / radius, probes[p].im / radius };
+	}
+	const T tolerance2 = T(tolerance * tolerance);
+
+	for (int n = 0; n < limit; n++) {
+		Complex Z2 = { T(2 * orbit.re[n]), T(2 * orbit.im[n]) };
+		next[0] = add<T>(mul<T>(Z2, a[0]), { radius, T(0.0) });
+		for (int k = 1; k < terms; k++) {
+			Complex sum = mul<T>(Z2, a[k]);
+			for (int j = 0; j < k; j++) {
+				sum = add<T>(sum, mul<T>(a[j], a[k - 1 - j]));
+			}
+			next[k] = sum;
+		}
+
+		bool valid = true;
+		for (size_t p = 0; p < probes.size() && valid; p++) {
+			exact[p] = add<T>(add<T>(mul<T>(Z2, exact[p]), mul<T>(exact[p], exact[p])), probes[p]);
+			Complex series = evaluateSeries<T>(next, scaled[p]);
+			Complex error = { series.re - exact[p].re, series.im - exact[p].im };
+			double zr = orbit.re[n + 1] + toDouble(exact[p].re);
+			double zi = orbit.im[n + 1] + toDouble(exact[p].im);
+			valid = norm<T>(error) <= tolerance2 * norm<T>(exact[p]) && zr * zr + zi * zi <= 4.0;
+		}
+		for (const Complex& c : next) {
+			valid = valid && isfinite(c.re) && isfinite(c.im);
+		}
+		if (!valid) {
+			break;
+		}
+
+		a.swap(next);
+		skip_iters = n + 1;
+	}
+	coefficients = a;
+}
+
+template <class T>
+typename SeriesApproximation<T>::Complex SeriesApproximation<T>::delta(const Complex& dc) const {
+	return evaluateSeries<T>(coefficients, { dc.re / radius, dc.im / radius });
+}
+
+template class SeriesApproximation<double>;
+template class SeriesApproximation<FloatExp>;
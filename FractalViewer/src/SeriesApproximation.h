@@ -0,0 +1,34 @@
+#pragma once
+
+#include "FloatExp.h"
+#include "ReferenceOrbit.h"
+
+#include <vector>
+
+// Truncated power series d(n) ~ sum A_k(n) dc^k around a reference orbit. Every pixel can start
+// at skip() with d taken from the series instead of iterating the shared leading iterations.
+// Coefficients are stored as A_k r^k with r the largest probe |dc| to keep them inside double range;
+// T is double, or FloatExp when dc itself is below double range.
+template <class T>
+class SeriesApproximation {
+public:
+	static constexpr int terms = 16;
+	// Largest relative error between the series and exactly iterated probes that is accepted
+	static constexpr double tolerance = 1e-12;
+
+	struct Complex {
+		T re, im;
+	};
+
+	// probes should bound the frame, e.g. its corners relative to the reference
+	void compute(const ReferenceOrbit& orbit, const std::vector<Complex>& probes, int limit);
+	void clear() { skip_iters = 0; }
+
+	int skip() const { return skip_iters; }
+	Complex delta(const Complex& dc) const;
+
+private:
+	int skip_iters = 0;
+	T radius = T(1.0);
+	std::vector<Complex> coefficients;
+};
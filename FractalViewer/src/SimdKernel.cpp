@@ -0,0 +1,245 @@
+#include "SimdKernel.h"
+#include "MandelbrotKernel.h"
+
+#include <cmath>
+#include <immintrin.h>
+
+#if defined(__GNUC__)
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#define TARGET_AVX512 __attribute__((target("avx512f")))
+#else
+#define TARGET_AVX2
+#define TARGET_AVX512
+#endif
+
+namespace {
+
+// Scalar bookkeeping shared by the vector loops: which pixel each lane holds and where the next one comes from.
+template <int N>
+struct Lanes {
+	alignas(64) double cre[N], cim[N], re[N], im[N], re2[N], im2[N], iters[N];
+	// Brent cycle detection and |dz/dz1|^2, as in MandelbrotKernel::evaluatePoint but checked every
+	// periodicity_interval trips of the vector loop, so a lane's saves land on arbitrary iterations
+	alignas(64) double save_re[N], save_im[N], next_save[N], derivative[N];
+	size_t index[N];
+	int busy = 0;
+	// Iterations run by the lanes that held a pixel
+	uint64_t iterations = 0;
+
+	const View& view;
+	Frame& frame;
+	const unsigned int* pixels;
+	size_t count;
+	size_t next = 0;
+	double center_re, center_im;
+	double period_tolerance2;
+	double derivative_threshold;
+
+	Lanes(const View& view, Frame& frame, const unsigned int* pixels, size_t count)
+		: view(view), frame(frame), pixels(pixels), count(count),
+		center_re(view.pos_x.toDouble()), center_im(view.pos_y.toDouble()) {
+		double tolerance = periodicityTolerance(view, MandelbrotKernel::periodicity_resolution);
+		period_tolerance2 = tolerance * tolerance;
+		derivative_threshold = exp2(interiorLog2Threshold(view));
+		for (int lane = 0; lane < N; lane++) {
+			refill(lane);
+		}
+	}
+
+	void refill(int lane) {
+		while (next < count) {
+			unsigned int pixel = pixels[next++];
+			double x = view.offsetRe(pixel % frame.width) + center_re;
+			double y = view.offsetIm(pixel / frame.width) + center_im;
+			if (MandelbrotKernel::inMainComponents(x, y)) {
+				frame.setInterior(pixel, view.max_iters);
+				continue;
+			}
+			cre[lane] = x;
+			cim[lane] = y;
+			re[lane] = im[lane] = re2[lane] = im2[lane] = iters[lane] = 0.0;
+			save_re[lane] = save_im[lane] = 0.0;
+			next_save[lane] = MandelbrotKernel::periodicity_interval;
+			derivative[lane] = 1.0;
+			index[lane] = pixel;
+			busy |= 1 << lane;
+			return;
+		}
+		// Parked lanes iterate c = 0, which never escapes
+		cre[lane] = cim[lane] = re[lane] = im[lane] = re2[lane] = im2[lane] = iters[lane] = 0.0;
+		save_re[lane] = save_im[lane] = 0.0;
+		next_save[lane] = MandelbrotKernel::periodicity_interval;
+		derivative[lane] = 1.0;
+		busy &= ~(1 << lane);
+	}
+
+	void finish(int lane, bool interior) {
+		int n = (int)iters[lane];
+		if (interior || n >= view.max_iters) {
+			frame.setInterior(index[lane], view.max_iters);
+			iterations += n;
+			return;
+		}
+		double i = 2 * re[lane] * im[lane] + cim[lane];
+		double r = re2[lane] - im2[lane] + cre[lane];
+		frame.setEscaped(index[lane], n + 1, r * r + i * i);
+		iterations += n + 1;
+	}
+
+	// interior marks the lanes the cycle or derivative check stopped
+	void retire(int mask, int interior) {
+		for (int lane = 0; lane < N; lane++) {
+			if (mask & (1 << lane)) {
+				finish(lane, (interior >> lane) & 1);
+				refill(lane);
+			}
+		}
+	}
+};
+
+TARGET_AVX2 uint64_t evaluateAvx2(const View& view, Frame& frame, const unsigned int* pixels, size_t count) {
+	Lanes<4> lanes(view, frame, pixels, count);
+	const __m256d one = _mm256_set1_pd(1.0);
+	const __m256d four = _mm256_set1_pd(4.0);
+	const __m256d maxIters = _mm256_set1_pd((double)view.max_iters);
+	const __m256d two = _mm256_set1_pd(2.0);
+	const __m256d tolerance2 = _mm256_set1_pd(lanes.period_tolerance2);
+	const __m256d threshold = _mm256_set1_pd(lanes.derivative_threshold);
+	unsigned int trips = 0;
+
+	while (lanes.busy) {
+		__m256d cre = _mm256_load_pd(lanes.cre);
+		__m256d cim = _mm256_load_pd(lanes.cim);
+		__m256d re = _mm256_load_pd(lanes.re);
+		__m256d im = _mm256_load_pd(lanes.im);
+		__m256d re2 = _mm256_load_pd(lanes.re2);
+		__m256d im2 = _mm256_load_pd(lanes.im2);
+		__m256d iters = _mm256_load_pd(lanes.iters);
+		__m256d saveRe = _mm256_load_pd(lanes.save_re);
+		__m256d saveIm = _mm256_load_pd(lanes.save_im);
+		__m256d nextSave = _mm256_load_pd(lanes.next_save);
+		__m256d derivative = _mm256_load_pd(lanes.derivative);
+		__m256d interior = _mm256_setzero_pd();
+
+		int done;
+		do {
+			__m256d reim = _mm256_mul_pd(re, im);
+			im = _mm256_add_pd(_mm256_add_pd(reim, reim), cim);
+			re = _mm256_add_pd(_mm256_sub_pd(re2, im2), cre);
+			re2 = _mm256_mul_pd(re, re);
+			im2 = _mm256_mul_pd(im, im);
+			iters = _mm256_add_pd(iters, one);
+
+			__m256d norm = _mm256_add_pd(re2, im2);
+			__m256d escaped = _mm256_cmp_pd(norm, four, _CMP_GT_OQ);
+			derivative = _mm256_mul_pd(derivative, _mm256_mul_pd(norm, four));
+			// Lanes that came back to their saved z or whose derivative vanished are interior
+			if (++trips % MandelbrotKernel::periodicity_interval == 0) {
+				__m256d dr = _mm256_sub_pd(re, saveRe);
+				__m256d di = _mm256_sub_pd(im, saveIm);
+				__m256d periodic = _mm256_cmp_pd(_mm256_add_pd(_mm256_mul_pd(dr, dr), _mm256_mul_pd(di, di)), tolerance2, _CMP_LT_OQ);
+				periodic = _mm256_or_pd(periodic, _mm256_cmp_pd(derivative, threshold, _CMP_LT_OQ));
+				interior = _mm256_andnot_pd(escaped, periodic);
+				__m256d save = _mm256_cmp_pd(iters, nextSave, _CMP_GE_OQ);
+				saveRe = _mm256_blendv_pd(saveRe, re, save);
+				saveIm = _mm256_blendv_pd(saveIm, im, save);
+				nextSave = _mm256_blendv_pd(nextSave, _mm256_mul_pd(nextSave, two), save);
+			}
+
+			__m256d capped = _mm256_cmp_pd(iters, maxIters, _CMP_GE_OQ);
+			done = _mm256_movemask_pd(_mm256_or_pd(_mm256_or_pd(escaped, capped), interior)) & lanes.busy;
+		} while (!done);
+
+		_mm256_store_pd(lanes.re, re);
+		_mm256_store_pd(lanes.im, im);
+		_mm256_store_pd(lanes.re2, re2);
+		_mm256_store_pd(lanes.im2, im2);
+		_mm256_store_pd(lanes.iters, iters);
+		_mm256_store_pd(lanes.save_re, saveRe);
+		_mm256_store_pd(lanes.save_im, saveIm);
+		_mm256_store_pd(lanes.next_save, nextSave);
+		_mm256_store_pd(lanes.derivative, derivative);
+		lanes.retire(done, _mm256_movemask_pd(interior));
+	}
+	return lanes.iterations;
+}
+
+TARGET_AVX512 uint64_t evaluateAvx512(const View& view, Frame& frame, const unsigned int* pixels, size_t count) {
+	Lanes<8> lanes(view, frame, pixels, count);
+	const __m512d one = _mm512_set1_pd(1.0);
+	const __m512d four = _mm512_set1_pd(4.0);
+	const __m512d maxIters = _mm512_set1_pd((double)view.max_iters);
+	const __m512d two = _mm512_set1_pd(2.0);
+	const __m512d tolerance2 = _mm512_set1_pd(lanes.period_tolerance2);
+	const __m512d threshold = _mm512_set1_pd(lanes.derivative_threshold);
+	unsigned int trips = 0;
+
+	while (lanes.busy) {
+		__m512d cre = _mm512_load_pd(lanes.cre);
+		__m512d cim = _mm512_load_pd(lanes.cim);
+		__m512d re = _mm512_load_pd(lanes.re);
+		__m512d im = _mm512_load_pd(lanes.im);
+		__m512d re2 = _mm512_load_pd(lanes.re2);
+		__m512d im2 = _mm512_load_pd(lanes.im2);
+		__m512d iters = _mm512_load_pd(lanes.iters);
+		__m512d saveRe = _mm512_load_pd(lanes.save_re);
+		__m512d saveIm = _mm512_load_pd(lanes.save_im);
+		__m512d nextSave = _mm512_load_pd(lanes.next_save);
+		__m512d derivative = _mm512_load_pd(lanes.derivative);
+		__mmask8 interior = 0;
+
+		int done;
+		do {
+			__m512d reim = _mm512_mul_pd(re, im);
+			im = _mm512_add_pd(_mm512_add_pd(reim, reim), cim);
+			re = _mm512_add_pd(_mm512_sub_pd(re2, im2), cre);
+			re2 = _mm512_mul_pd(re, re);
+			im2 = _mm512_mul_pd(im, im);
+			iters = _mm512_add_pd(iters, one);
+
+			__m512d norm = _mm512_add_pd(re2, im2);
+			__mmask8 escaped = _mm512_cmp_pd_mask(norm, four, _CMP_GT_OQ);
+			derivative = _mm512_mul_pd(derivative, _mm512_mul_pd(norm, four));
+			if (++trips % MandelbrotKernel::periodicity_interval == 0) {
+				__m512d dr = _mm512_sub_pd(re, saveRe);
+				__m512d di = _mm512_sub_pd(im, saveIm);
+				__mmask8 periodic = _mm512_cmp_pd_mask(_mm512_add_pd(_mm512_mul_pd(dr, dr), _mm512_mul_pd(di, di)), tolerance2, _CMP_LT_OQ);
+				interior = (periodic | _mm512_cmp_pd_mask(derivative, threshold, _CMP_LT_OQ)) & ~escaped;
+				__mmask8 save = _mm512_cmp_pd_mask(iters, nextSave, _CMP_GE_OQ);
+				saveRe = _mm512_mask_blend_pd(save, saveRe, re);
+				saveIm = _mm512_mask_blend_pd(save, saveIm, im);
+				nextSave = _mm512_mask_blend_pd(save, nextSave, _mm512_mul_pd(nextSave, two));
+			}
+
+			__mmask8 capped = _mm512_cmp_pd_mask(iters, maxIters, _CMP_GE_OQ);
+			done = (int)(escaped | capped | interior) & lanes.busy;
+		} while (!done);
+
+		_mm512_store_pd(lanes.re, re);
+		_mm512_store_pd(lanes.im, im);
+		_mm512_store_pd(lanes.re2, re2);
+		_mm512_store_pd(lanes.im2, im2);
+		_mm512_store_pd(lanes.iters, iters);
+		_mm512_store_pd(lanes.save_re, saveRe);
+		_mm512_store_pd(lanes.save_im, saveIm);
+		_mm512_store_pd(lanes.next_save, nextSave);
+		_mm512_store_pd(lanes.derivative, derivative);
+		lanes.retire(done, interior);
+	}
+	return lanes.iterations;
+}
+
+}
+
+SimdKernel::SimdKernel(KernelIsa isa) : isa(isa) {}
+
+uint64_t SimdKernel::evaluate(const View& view, Frame& frame, const unsigned int* pixels, size_t count) const {
+	switch (isa) {
+	case KernelIsa::Avx512:
+		return evaluateAvx512(view, frame, pixels, count);
+	case KernelIsa::Avx2:
+		return evaluateAvx2(view, frame, pixels, count);
+	default:
+		return MandelbrotKernel().evaluate(view, frame, pixels, count);
+	}
+}
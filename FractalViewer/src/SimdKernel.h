@@ -0,0 +1,17 @@
+#pragma once
+
+#include "Kernel.h"
+
+// Double-precision escape-time kernel that iterates 4 (AVX2) or 8 (AVX-512) pixels at once.
+// Lanes that escape are finished and immediately refilled from the pixel list so no lane idles
+// while its neighbours are still iterating.
+class SimdKernel : public Kernel {
+public:
+	explicit SimdKernel(KernelIsa isa);
+
+	const char* name() const override { return kernelIsaName(isa); }
+	uint64_t evaluate(const View& view, Frame& frame, const unsigned int* pixels, size_t count) const override;
+
+private:
+	KernelIsa isa;
+};
@@ -0,0 +1,119 @@
+#include "TileScheduler.h"
+
+#include "Trace.h"
+
+#include <algorithm>
+
+std::vector<Tile> makeTiles(unsigned int width, unsigned int height, unsigned int tileSize) {
+	std::vector<Tile> tiles;
+	makeTiles({ 0, 0, width, height }, tileSize, tiles);
+	return tiles;
+}
+
+void makeTiles(const Tile& area, unsigned int tileSize, std::vector<Tile>& tiles) {
+	for (unsigned int y = area.y0; y < area.y1; y += tileSize) {
+		for (unsigned int x = area.x0; x < area.x1; x += tileSize) {
+			tiles.push_back({ x, y, std::min(x + tileSize, area.x1), std::min(y + tileSize, area.y1) });
+		}
+	}
+}
+
+TileScheduler::TileScheduler(unsigned int threads) {
+	if (threads == 0) {
+		threads = std::max(1u, std::thread::hardware_concurrency());
+	}
+	for (unsigned int i = 0; i < threads; i++) {
+		workers.push_back(std::make_unique<Worker>());
+	}
+	for (unsigned int i = 1; i < threads; i++) {
+		this->threads.emplace_back(&TileScheduler::threadMain, this, i);
+	}
+}
+
+TileScheduler::~TileScheduler() {
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stopping = true;
+	}
+	wake.notify_all();
+	for (std::thread& thread : threads) {
+		thread.join();
+	}
+}
+
+void TileScheduler::run(size_t count, const Task& task) {
+	if (count == 0) {
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		// Published before the indices so a worker still stealing from the last run sees this task
+		current = &task;
+		remaining = count;
+		for (size_t i = 0; i < count; i++) {
+			Worker& worker = *workers[i % workers.size()];
+			std::lock_guard<std::mutex> queueLock(worker.mutex);
+			worker.queue.push_back(i);
+		}
+		generation++;
+	}
+	wake.notify_all();
+
+	work(0);
+
+	std::unique_lock<std::mutex> lock(mutex);
+	done.wait(lock, [this] { return remaining == 0; });
+	current = nullptr;
+}
+
+bool TileScheduler::pop(unsigned int id, size_t& index) {
+	Worker& worker = *workers[id];
+	std::lock_guard<std::mutex> lock(worker.mutex);
+	if (worker.queue.empty()) {
+		return false;
+	}
+	index = worker.queue.front();
+	worker.queue.pop_front();
+	return true;
+}
+
+bool TileScheduler::steal(unsigned int id, size_t& index) {
+	for (size_t i = 1; i < workers.size(); i++) {
+		Worker& victim = *workers[(id + i) % workers.size()];
+		std::lock_guard<std::mutex> lock(victim.mutex);
+		if (!victim.queue.empty()) {
+			index = victim.queue.back();
+			victim.queue.pop_back();
+			return true;
+		}
+	}
+	return false;
+}
+
+void TileScheduler::work(unsigned int id) {
+	size_t index;
+	while (pop(id, index) || steal(id, index)) {
+		(*current)(index, id);
+		if (--remaining == 0) {
+			std::lock_guard<std::mutex> lock(mutex);
+			done.notify_all();
+		}
+	}
+}
+
+void TileScheduler::threadMain(unsigned int id) {
+	setTraceThreadName("worker " + std::to_string(id));
+	unsigned long long seen = 0;
+	for (;;) {
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			wake.wait(lock, [&] { return stopping || generation != seen; });
+			if (stopping) {
+				return;
+			}
+			seen = generation;
+		}
+		work(id);
+	}
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+struct Tile {
+	unsigned int x0, y0, x1, y1;
+};
+
+std::vector<Tile> makeTiles(unsigned int width, unsigned int height, unsigned int tileSize);
+// Appends tiles covering area to tiles
+void makeTiles(const Tile& area, unsigned int tileSize, std::vector<Tile>& tiles);
+
+// Persistent thread pool that hands out task indices through per-thread deques.
+// Each worker drains its own deque from the front and steals from the back of the others.
+class TileScheduler {
+public:
+	using Task = std::function<void(size_t index, unsigned int worker)>;
+
+	explicit TileScheduler(unsigned int threads = 0);
+	~TileScheduler();
+
+	TileScheduler(const TileScheduler&) = delete;
+	TileScheduler& operator=(const TileScheduler&) = delete;
+
+	unsigned int threadCount() const { return (unsigned int)workers.size(); }
+
+	// Runs task for every index in [0, count); the calling thread works as worker 0.
+	void run(size_t count, const Task& task);
+
+private:
+	struct Worker {
+		std::mutex mutex;
+		std::deque<size_t> queue;
+	};
+
+	bool pop(unsigned int id, size_t& index);
+	bool steal(unsigned int id, size_t& index);
+	void work(unsigned int id);
+	void threadMain(unsigned int id);
+
+	std::vector<std::unique_ptr<Worker>> workers;
+	std::vector<std::thread> threads;
+
+	std::mutex mutex;
+	std::condition_variable wake;
+	std::condition_variable done;
+	const Task* current = nullptr;
+	std::atomic<size_t> remaining{ 0 };
+	unsigned long long generation = 0;
+	bool stopping = false;
+};
@@ -0,0 +1,117 @@
+#include "Trace.h"
+
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+std::atomic<bool> trace_enabled{ false };
+
+namespace {
+
+// Per thread; more are dropped so a forgotten trace can't take all memory
+constexpr size_t max_events = 1 << 20;
+
+struct Event {
+	const char* name;
+	int64_t start_ns, duration_ns;
+	int x, y;
+};
+
+// Each thread appends to its own buffer; the mutex is only ever contended by stopTrace()
+struct ThreadBuffer {
+	std::mutex mutex;
+	unsigned int id = 0;
+	std::string name;
+	std::vector<Event> events;
+};
+
+std::mutex registry_mutex;
+// Never freed, so threads that exit mid-trace leave their events behind safely
+std::vector<std::unique_ptr<ThreadBuffer>> buffers;
+std::string output_path;
+std::atomic<int64_t> origin_ns{ 0 };
+
+int64_t nanoseconds(std::chrono::steady_clock::time_point time) {
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(time.time_since_epoch()).count();
+}
+
+ThreadBuffer& threadBuffer() {
+	thread_local ThreadBuffer* buffer = nullptr;
+	if (!buffer) {
+		std::lock_guard<std::mutex> lock(registry_mutex);
+		buffers.push_back(std::make_unique<ThreadBuffer>());
+		buffer = buffers.back().get();
+		buffer->id = (unsigned int)buffers.size();
+	}
+	return *buffer;
+}
+
+}
+
+void startTrace(const std::string& path) {
+	std::lock_guard<std::mutex> lock(registry_mutex);
+	for (std::unique_ptr<ThreadBuffer>& buffer : buffers) {
+		std::lock_guard<std::mutex> buffer_lock(buffer->mutex);
+		buffer->events.clear();
+	}
+	output_path = path;
+	origin_ns = nanoseconds(std::chrono::steady_clock::now());
+	trace_enabled = true;
+}
+
+bool stopTrace() {
+	if (!trace_enabled.exchange(false)) {
+		return true;
+	}
+	std::lock_guard<std::mutex> lock(registry_mutex);
+	std::ofstream out(output_path);
+	// Timestamps are in microseconds
+	out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+	bool first = true;
+	for (std::unique_ptr<ThreadBuffer>& buffer : buffers) {
+		std::lock_guard<std::mutex> buffer_lock(buffer->mutex);
+		if (!buffer->name.empty()) {
+			out << (first ? "" : ",") << "\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << buffer->id
+				<< ",\"args\":{\"name\":\"" << buffer->name << "\"}}";
+			first = false;
+		}
+		for (const Event& event : buffer->events) {
+			out << (first ? "" : ",") << "\n{\"name\":\"" << event.name << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << buffer->id
+				<< ",\"ts\":" << event.start_ns / 1000 << '.' << event.start_ns % 1000 / 100
+				<< ",\"dur\":" << event.duration_ns / 1000 << '.' << event.duration_ns % 1000 / 100;
+			if (event.x >= 0) {
+				out << ",\"args\":{\"x\":" << event.x << ",\"y\":" << event.y << '}';
+			}
+			out << '}';
+			first = false;
+		}
+		buffer->events.clear();
+	}
+	out << "\n]}\n";
+	return out.good();
+}
+
+void setTraceThreadName(const std::string& name) {
+	if (!tracing()) {
+		return;
+	}
+	ThreadBuffer& buffer = threadBuffer();
+	std::lock_guard<std::mutex> lock(buffer.mutex);
+	buffer.name = name;
+}
+
+void TraceScope::record() {
+	int64_t end = nanoseconds(std::chrono::steady_clock::now()) - origin_ns.load(std::memory_order_relaxed);
+	int64_t begin = nanoseconds(start) - origin_ns.load(std::memory_order_relaxed);
+	// Started before the current trace
+	if (begin < 0) {
+		return;
+	}
+	ThreadBuffer& buffer = threadBuffer();
+	std::lock_guard<std::mutex> lock(buffer.mutex);
+	if (buffer.events.size() < max_events) {
+		buffer.events.push_back({ name, begin, end - begin, x, y });
+	}
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <string>
+
+// Records what every thread works on in the trace event format of chrome://tracing and Perfetto.
+// Nothing is recorded until startTrace(); until then a TraceScope costs one relaxed atomic load.
+extern std::atomic<bool> trace_enabled;
+
+inline bool tracing() { return trace_enabled.load(std::memory_order_relaxed); }
+
+// Events are kept in memory and written to path by stopTrace()
+void startTrace(const std::string& path);
+// False when the file couldn't be written
+bool stopTrace();
+// Labels the calling thread in the trace; threads that record before naming themselves show up by number
+void setTraceThreadName(const std::string& name);
+
+// Records its lifetime as one complete event on the calling thread. name has to outlive the trace.
+class TraceScope {
+public:
+	explicit TraceScope(const char* name) : TraceScope(name, -1, -1) {}
+	// x and y are attached as arguments, e.g. the corner of a tile
+	TraceScope(const char* name, int x, int y) {
+		if (tracing()) {
+			this->name = name;
+			this->x = x;
+			this->y = y;
+			start = std::chrono::steady_clock::now();
+		}
+	}
+	~TraceScope() {
+		if (name) {
+			record();
+		}
+	}
+
+	TraceScope(const TraceScope&) = delete;
+	TraceScope& operator=(const TraceScope&) = delete;
+
+private:
+	void record();
+
+	const char* name = nullptr;
+	int x = -1, y = -1;
+	std::chrono::steady_clock::time_point start;
+};
@@ -0,0 +1,322 @@
+#include "Verify.h"
+#include "CpuFeatures.h"
+#include "DoubleDouble.h"
+#include "MandelbrotKernel.h"
+#include "Renderer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace {
+
+struct VerifyView {
+	const char* name;
+	const char* re;
+	const char* im;
+	double zoom;
+	int max_iters;
+	// Compared pixels are this far apart in both directions; views too deep for a double-double
+	// reference use a sparse grid so the BigFixed reference finishes
+	unsigned int spacing;
+};
+
+constexpr unsigned int verify_width = 640, verify_height = 360;
+// Extra fraction limbs of the BigFixed reference, so its rounding stays far below that of the engines
+constexpr unsigned int reference_guard_limbs = 4;
+// Double-double keeps some 32 digits, which orbits passing near repelling points amplify into whole
+// pixels well before Renderer::double_double_pixel_size, so deeper references go through BigFixed
+constexpr double double_double_reference_pixel_size = 1e-24;
+
+const VerifyView verify_views[] = {
+	{ "full", "-0.5", "0", 0.0, 1000, 1 },
+	{ "seahorse", "-0.7436438870371587", "0.1318259042053119", 3.0, 5000, 1 },
+	{ "elephant", "0.2925", "0.015", 2.0, 3000, 1 },
+	{ "minibrot", "-1.7548776662466927600495", "0", 1.8, 20000, 1 },
+	// Around c = i as in bench; checked against double-double and against BigFixed
+	{ "deep-1e20", "0", "1", 20.0, 3000, 1 },
+	{ "deep-1e50", "0", "1", 50.0, 3000, 8 },
+	// Bench's deep-minibrot at a budget the BigFixed reference can afford; its interior pixels start
+	// from the series skip
+	{ "minibrot-1e24", "-0.101096363845294927955634900413589339565258", "0.956286510809698630152005513221601006819917", 24.0, 3000, 4 },
+	// Beside c = i the reference escapes before a third of the pixels do; past double_double_pixel_size
+	// the renderer resolves them with extra references
+	{ "glitch-1e30", "0.000000000000000000000000000003", "1", 30.0, 3000, 4 },
+	// Pixel size below 2^-960, where the perturbation kernel starts its deltas in FloatExp
+	{ "deep-1e320", "0", "1", 320.0, 3000, 16 },
+};
+
+// How an engine arrives at the view: in one render(), coarse to fine, or the ways the viewer does
+// after a pan, a zoom or a view it abandoned halfway
+enum class Route {
+	Render,
+	Progressive,
+	// render() of a view pan_pixels away, then render() of the view, which shifts the last frame
+	Pan,
+	// render() of the view zoomed out by zoom_step, then preview() and refine()
+	Zoom,
+	// begin() of a view pan_pixels away cancelled after one refine() slice, then preview() and refine()
+	Cancel
+};
+
+// Odd in both directions so the shift doesn't line up with the tiles
+const int pan_pixels[2] = { 7, 3 };
+const double zoom_step = log(2.0);
+
+struct Engine {
+	const char* name;
+	KernelIsa isa;
+	TileMethod method;
+	Route route;
+	// Largest fraction of the compared pixels that may differ from the reference
+	double tolerance;
+};
+
+std::vector<Engine> engineList() {
+	KernelIsa best = bestKernelIsa();
+	return {
+		{ "scalar", KernelIsa::Scalar, TileMethod::Full, Route::Render, 0.001 },
+		{ "avx2", KernelIsa::Avx2, TileMethod::Full, Route::Render, 0.001 },
+		{ "avx512", KernelIsa::Avx512, TileMethod::Full, Route::Render, 0.001 },
+		{ "mariani-silver", best, TileMethod::MarianiSilver, Route::Render, 0.005 },
+		{ "boundary-trace", best, TileMethod::BoundaryTrace, Route::Render, 0.01 },
+		{ "progressive", best, TileMethod::MarianiSilver, Route::Progressive, 0.005 },
+		{ "pan", best, TileMethod::MarianiSilver, Route::Pan, 0.005 },
+		{ "zoom", best, TileMethod::MarianiSilver, Route::Zoom, 0.005 },
+		{ "cancel", best, TileMethod::MarianiSilver, Route::Cancel, 0.005 },
+	};
+}
+
+bool supported(KernelIsa isa) {
+	switch (isa) {
+	case KernelIsa::Avx512:
+		return cpuFeatures().avx512f;
+	case KernelIsa::Avx2:
+		return cpuFeatures().avx2;
+	default:
+		return true;
+	}
+}
+
+View makeView(const VerifyView& verify) {
+	View view;
+	view.width = verify_width;
+	view.height = verify_height;
+	view.max_iters = verify.max_iters;
+	View::parse(verify.re, verify.im, verify.zoom, view);
+	return view;
+}
+
+inline double toDouble(double x) { return x; }
+inline double toDouble(const DoubleDouble& x) { return x.toDouble(); }
+inline double toDouble(const BigFixed& x) { return x.toDouble(); }
+
+// The loop of fragment.glsl main() in the arithmetic of Number
+template <class Number>
+void escape(const View& view, Frame& frame, size_t index, const Number& cre, const Number& cim) {
+	if (MandelbrotKernel::inMainComponents(toDouble(cre), toDouble(cim))) {
+		frame.setInterior(index, view.max_iters);
+		return;
+	}
+
+	int iters = 0;
+	Number re(0.0), im(0.0), re2(0.0), im2(0.0);
+	while (toDouble(re2 + im2) <= 4 && iters < view.max_iters) {
+		Number product = re * im;
+		im = product + product + cim;
+		re = re2 - im2 + cre;
+		re2 = re * re;
+		im2 = im * im;
+		iters++;
+	}
+	if (iters == view.max_iters) {
+		frame.setInterior(index, view.max_iters);
+		return;
+	}
+
+	Number product = re * im;
+	im = product + product + cim;
+	re = re2 - im2 + cre;
+	re2 = re * re;
+	im2 = im * im;
+	iters++;
+	frame.setEscaped(index, iters, toDouble(re2 + im2));
+}
+
+DoubleDouble toDoubleDouble(const BigFixed& x) {
+	double hi = x.toDouble();
+	double lo = (x - BigFixed(hi, x.fracLimbs())).toDouble();
+	return DoubleDouble::quickTwoSum(hi, lo);
+}
+
+void referencePixel(const View& view, Frame& frame, unsigned int pixel) {
+	unsigned int x = pixel % view.width, y = pixel / view.width;
+	if (view.pixelSize() >= Renderer::deep_pixel_size) {
+		escape<double>(view, frame, pixel, view.pos_x.toDouble() + view.offsetRe(x), view.pos_y.toDouble() + view.offsetIm(y));
+	} else if (view.pixelSize() >= double_double_reference_pixel_size) {
+		escape<DoubleDouble>(view, frame, pixel, toDoubleDouble(view.pos_x) + view.offsetRe(x),
+			toDoubleDouble(view.pos_y) + view.offsetIm(y));
+	} else {
+		unsigned int limbs = View::precisionLimbs(view.zoom_level) + reference_guard_limbs;
+		BigFixed cre = view.pos_x.withPrecision(limbs) + View::planeDistance(x + 0.5 - view.width * 0.5, view.zoom_level);
+		BigFixed cim = view.pos_y.withPrecision(limbs) + View::planeDistance(y + 0.5 - view.height * 0.5, view.zoom_level);
+		escape<BigFixed>(view, frame, pixel, cre, cim);
+	}
+}
+
+std::vector<unsigned int> comparedPixels(const View& view, unsigned int spacing) {
+	std::vector<unsigned int> pixels;
+	for (unsigned int y = spacing / 2; y < view.height; y += spacing) {
+		for (unsigned int x = spacing / 2; x < view.width; x += spacing) {
+			pixels.push_back(y * view.width + x);
+		}
+	}
+	return pixels;
+}
+
+void renderReference(TileScheduler& scheduler, const View& view, Frame& frame, const std::vector<unsigned int>& pixels) {
+	frame.resize(view.width, view.height);
+	const size_t chunk = 256;
+	scheduler.run((pixels.size() + chunk - 1) / chunk, [&](size_t index, unsigned int /*worker*/) {
+		for (size_t i = index * chunk; i < std::min(pixels.size(), (index + 1) * chunk); i++) {
+			referencePixel(view, frame, pixels[i]);
+		}
+	});
+}
+
+struct Comparison {
+	size_t compared = 0;
+	// Pixels with another iteration count or the other side of interior and escaped
+	size_t differing = 0;
+	size_t class_mismatches = 0;
+	// Over the escaped pixels with another iteration count
+	double mean_delta = 0.0;
+	int max_delta = 0;
+};
+
+Comparison compare(const Frame& frame, const Frame& reference, const std::vector<unsigned int>& pixels) {
+	Comparison result;
+	result.compared = pixels.size();
+	size_t escaped = 0;
+	double total = 0.0;
+	for (unsigned int pixel : pixels) {
+		// Glitched pixels left over count as wrongly classified
+		bool interior = frame.isInterior(pixel) || frame.isGlitched(pixel);
+		if (interior != reference.isInterior(pixel) || frame.isGlitched(pixel)) {
+			result.differing++;
+			result.class_mismatches++;
+		} else if (!interior && frame.iterations[pixel] != reference.iterations[pixel]) {
+			int delta = std::abs(frame.iterations[pixel] - reference.iterations[pixel]);
+			result.differing++;
+			escaped++;
+			total += delta;
+			result.max_delta = std::max(result.max_delta, delta);
+		}
+	}
+	result.mean_delta = escaped > 0 ? total / escaped : 0.0;
+	return result;
+}
+
+View panned(const View& view) {
+	View from = view;
+	from.pos_x = view.pos_x - View::planeDistance(pan_pixels[0], view.zoom_level);
+	from.pos_y = view.pos_y - View::planeDistance(pan_pixels[1], view.zoom_level);
+	return from;
+}
+
+void render(TileScheduler& scheduler, const Engine& engine, const View& view, Frame& frame, std::string& kernel_name) {
+	Renderer renderer(scheduler, createKernel(engine.isa));
+	renderer.setTileMethod(engine.method);
+	kernel_name = renderer.kernelFor(view).name();
+	switch (engine.route) {
+	case Route::Render:
+		renderer.render(view, frame);
+		return;
+	case Route::Progressive:
+		renderer.begin(view, frame);
+		break;
+	case Route::Pan:
+		renderer.render(panned(view), frame);
+		renderer.render(view, frame);
+		return;
+	case Route::Zoom: {
+		View from = view;
+		from.zoom_level -= zoom_step;
+		renderer.render(from, frame);
+		if (!renderer.preview(view, frame)) {
+			renderer.begin(view, frame);
+		}
+		break;
+	}
+	case Route::Cancel:
+		renderer.begin(panned(view), frame);
+		renderer.refine(frame, 0.0);
+		if (!renderer.preview(view, frame)) {
+			renderer.begin(view, frame);
+		}
+		break;
+	}
+	while (renderer.refine(frame, 1.0)) {
+	}
+}
+
+}
+
+int runVerify(int argc, char** argv) {
+	std::string only_view, only_engine;
+	for (int i = 0; i < argc; i++) {
+		std::string arg = argv[i];
+		if (arg == "--view" && i + 1 < argc) {
+			only_view = argv[++i];
+		} else if (arg == "--engine" && i + 1 < argc) {
+			only_engine = argv[++i];
+		} else {
+			std::cout << "Usage: FractalViewer verify [--view NAME] [--engine NAME]" << std::endl;
+			return 1;
+		}
+	}
+
+	TileScheduler scheduler;
+	std::vector<Engine> engines = engineList();
+	bool failed = false;
+	std::cout << std::left << std::setw(16) << "view" << std::setw(16) << "engine" << std::setw(14) << "kernel" << std::right
+		<< std::setw(10) << "compared" << std::setw(11) << "differing" << std::setw(10) << "class" << std::setw(11) << "mean |d|"
+		<< std::setw(9) << "max |d|" << std::setw(11) << "tolerance" << std::endl;
+	for (const VerifyView& verify : verify_views) {
+		if (!only_view.empty() && only_view != verify.name) {
+			continue;
+		}
+		View view = makeView(verify);
+		std::vector<unsigned int> pixels = comparedPixels(view, verify.spacing);
+		Frame reference;
+		renderReference(scheduler, view, reference, pixels);
+
+		for (const Engine& engine : engines) {
+			if (!only_engine.empty() && only_engine != engine.name) {
+				continue;
+			}
+			// Below deep_pixel_size every engine goes through the perturbation kernel, whatever its ISA
+			if (!supported(engine.isa) || (view.pixelSize() < Renderer::deep_pixel_size && engine.isa != bestKernelIsa())) {
+				continue;
+			}
+			Frame frame;
+			std::string kernel_name;
+			render(scheduler, engine, view, frame, kernel_name);
+			Comparison result = compare(frame, reference, pixels);
+			double fraction = (double)result.differing / result.compared;
+			bool passed = fraction <= engine.tolerance;
+			failed |= !passed;
+			std::cout << std::left << std::setw(16) << verify.name << std::setw(16) << engine.name << std::setw(14) << kernel_name
+				<< std::right << std::setw(10) << result.compared << std::fixed << std::setprecision(3)
+				<< std::setw(10) << fraction * 100.0 << '%' << std::setw(10) << result.class_mismatches
+				<< std::setprecision(2) << std::setw(11) << result.mean_delta << std::setw(9) << result.max_delta
+				<< std::setprecision(3) << std::setw(10) << engine.tolerance * 100.0 << '%'
+				<< (passed ? "" : "  FAILED") << std::endl;
+		}
+	}
+	return failed ? 1 : 0;
+}
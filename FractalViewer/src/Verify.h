@@ -0,0 +1,7 @@
+#pragma once
+
+// `FractalViewer verify [--view NAME] [--engine NAME]` renders a corpus of views with every engine and
+// compares the iteration buffers with a plain port of the escape loop of the original fragment.glsl,
+// without periodicity checks, interior shortcuts beyond the cardioid test or perturbation. Prints
+// per-pixel difference statistics and returns nonzero when an engine exceeds its tolerance.
+int runVerify(int argc, char** argv);